@@ -199,7 +199,10 @@ void GifsListWidget::cancelGifsSearch() {
 	}
 	_inlineRequestTimer.stop();
 	_inlineQuery = _inlineNextQuery = _inlineNextOffset = QString();
-	_inlineCache.clear();
+
+	// Keep the results cached, so that searching again is instant,
+	// only the layouts are destroyed together with the rows.
+	_inlineShownEntry = nullptr;
 	refreshInlineRows(nullptr, true);
 }
 
@@ -218,6 +221,8 @@ void GifsListWidget::inlineResultsDone(const MTPmessages_BotResults &result) {
 
 		if (it == _inlineCache.cend()) {
 			it = _inlineCache.emplace(_inlineQuery, std::make_unique<InlineCacheEntry>()).first;
+			it->second->expires = InlineBots::ResultsCacheExpires(
+				d.vcache_time.v);
 		}
 		auto entry = it->second.get();
 		entry->nextOffset = qs(d.vnext_offset);
@@ -242,6 +247,9 @@ void GifsListWidget::inlineResultsDone(const MTPmessages_BotResults &result) {
 	if (!showInlineRows(!adding)) {
 		it->second->nextOffset = QString();
 	}
+	InlineBots::TrimResultsCache(_inlineCache, _inlineShownEntry, [&] {
+		deleteUnusedInlineLayouts();
+	});
 	checkLoadMore();
 }
 
@@ -782,7 +790,9 @@ bool GifsListWidget::refreshInlineRows(int32 *added) {
 	if (it != _inlineCache.cend()) {
 		entry = it->second.get();
 		_inlineNextOffset = it->second->nextOffset;
+		it->second->used = getms(true);
 	}
+	_inlineShownEntry = entry;
 	auto result = refreshInlineRows(entry, false);
 	if (added) *added = result;
 	return (entry != nullptr);
@@ -809,7 +819,7 @@ void GifsListWidget::searchForGifs(const QString &query) {
 			request(_inlineRequestId).cancel();
 			_inlineRequestId = 0;
 		}
-		if (_inlineCache.find(query) != _inlineCache.cend()) {
+		if (InlineBots::FreshResultsCacheEntry(_inlineCache, query)) {
 			_inlineRequestTimer.stop();
 			_inlineQuery = _inlineNextQuery = query;
 			showInlineRows(true);
@@ -851,6 +861,14 @@ void GifsListWidget::sendInlineRequest() {
 
 	auto nextOffset = QString();
 	auto it = _inlineCache.find(_inlineQuery);
+	if (it != _inlineCache.cend()
+		&& it->second.get() != _inlineShownEntry
+		&& InlineBots::ResultsCacheEntryExpired(*it->second)) {
+		// Request the expired results again from the beginning.
+		deleteUnusedInlineLayouts();
+		_inlineCache.erase(it);
+		it = _inlineCache.end();
+	}
 	if (it != _inlineCache.cend()) {
 		nextOffset = it->second->nextOffset;
 		if (nextOffset.isEmpty()) {
@@ -9,6 +9,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 #include "chat_helpers/tabbed_selector.h"
 #include "inline_bots/inline_bot_layout_item.h"
+#include "inline_bots/inline_results_cache.h"
 
 namespace InlineBots {
 namespace Layout {
@@ -102,6 +103,8 @@ private:
 	struct InlineCacheEntry {
 		QString nextOffset;
 		InlineResults results;
+		TimeMs expires = 0;
+		TimeMs used = 0;
 	};
 
 	void cancelGifsSearch();
@@ -156,7 +159,8 @@ private:
 	QTimer _previewTimer;
 	bool _previewShown = false;
 
-	std::map<QString, std::unique_ptr<InlineCacheEntry>> _inlineCache;
+	InlineBots::ResultsCache<InlineCacheEntry> _inlineCache;
+	const InlineCacheEntry *_inlineShownEntry = nullptr;
 	QTimer _inlineRequestTimer;
 
 	UserData *_searchBot = nullptr;
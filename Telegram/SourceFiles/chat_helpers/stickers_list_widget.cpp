@@ -712,6 +712,16 @@ void StickersListWidget::visibleTopBottomUpdated(
 	if (_section == Section::Featured) {
 		readVisibleSets();
 	}
+
+	// Start loading the stickers one screen before they are shown.
+	const auto visibleHeight = (visibleBottom - visibleTop);
+	if (visibleHeight > 0) {
+		if (visibleTop > top) {
+			preloadStickers(visibleBottom, visibleBottom + visibleHeight);
+		} else if (visibleTop < top) {
+			preloadStickers(visibleTop - visibleHeight, visibleTop);
+		}
+	}
 	validateSelectedIcon(ValidateIconAnimations::Full);
 }
 
@@ -780,27 +790,65 @@ bool StickersListWidget::enumerateSections(Callback callback) const {
 	return true;
 }
 
-StickersListWidget::SectionInfo StickersListWidget::sectionInfo(int section) const {
-	Expects(section >= 0 && section < shownSets().size());
-	auto result = SectionInfo();
-	enumerateSections([searchForSection = section, &result](const SectionInfo &info) {
-		if (info.section == searchForSection) {
-			result = info;
+template <typename Callback>
+bool StickersListWidget::enumerateSectionsFrom(
+		int yOffset,
+		Callback callback) const {
+	const auto &list = sections();
+	const auto from = std::upper_bound(
+		list.begin(),
+		list.end(),
+		yOffset,
+		[](int offset, const SectionInfo &info) {
+			return offset < info.rowsBottom;
+		});
+	for (auto i = from; i != list.end(); ++i) {
+		if (!callback(*i)) {
 			return false;
 		}
+	}
+	return true;
+}
+
+auto StickersListWidget::sectionsKey() const -> SectionsKey {
+	auto result = SectionsKey();
+	result.section = _section;
+	result.setsCount = shownSets().size();
+	result.columnCount = _columnCount;
+	result.rowHeight = _singleSize.height();
+	result.megagroupBottom = _megagroupSetButtonRect.y()
+		+ _megagroupSetButtonRect.height();
+	return result;
+}
+
+void StickersListWidget::refreshSections() const {
+	_sectionsKey = sectionsKey();
+	_sections.clear();
+	_sections.reserve(_sectionsKey.setsCount);
+	enumerateSections([&](const SectionInfo &info) {
+		_sections.push_back(info);
 		return true;
 	});
-	return result;
+}
+
+auto StickersListWidget::sections() const -> const std::vector<SectionInfo> & {
+	if (!(_sectionsKey == sectionsKey())) {
+		refreshSections();
+	}
+	return _sections;
+}
+
+StickersListWidget::SectionInfo StickersListWidget::sectionInfo(int section) const {
+	Expects(section >= 0 && section < shownSets().size());
+	return sections()[section];
 }
 
 StickersListWidget::SectionInfo StickersListWidget::sectionInfoByOffset(int yOffset) const {
-	auto result = SectionInfo();
-	enumerateSections([this, &result, yOffset](const SectionInfo &info) {
-		if (yOffset < info.rowsBottom || info.section == shownSets().size() - 1) {
-			result = info;
-			return false;
-		}
-		return true;
+	const auto &list = sections();
+	auto result = list.empty() ? SectionInfo() : list.back();
+	enumerateSectionsFrom(yOffset, [&](const SectionInfo &info) {
+		result = info;
+		return false;
 	});
 	return result;
 }
@@ -821,6 +869,7 @@ int StickersListWidget::countDesiredHeight(int newWidth) {
 		- st::buttonRadius;
 	_singleSize = QSize(singleWidth, singleWidth);
 	setColumnCount(columnCount);
+	refreshSections();
 
 	auto visibleHeight = minimalHeight();
 	auto minimalHeight = (visibleHeight - st::stickerPanPadding);
@@ -1134,10 +1183,8 @@ void StickersListWidget::paintStickers(Painter &p, QRect clip) {
 	if (sets.empty() && _section == Section::Search) {
 		paintEmptySearchResults(p);
 	}
-	enumerateSections([&](const SectionInfo &info) {
-		if (clip.top() >= info.rowsBottom) {
-			return true;
-		} else if (clip.top() + clip.height() <= info.top) {
+	enumerateSectionsFrom(clip.top(), [&](const SectionInfo &info) {
+		if (clip.top() + clip.height() <= info.top) {
 			return false;
 		}
 		auto &set = sets[info.section];
@@ -1755,30 +1802,46 @@ void StickersListWidget::refreshFooterIcons() {
 }
 
 void StickersListWidget::preloadImages() {
+	const auto visibleTop = getVisibleTop();
+	const auto visibleHeight = std::max(
+		getVisibleBottom() - visibleTop,
+		minimalHeight());
+	preloadStickers(visibleTop - visibleHeight, visibleTop + 2 * visibleHeight);
+	if (_footer) {
+		_footer->preloadImages();
+	}
+}
+
+void StickersListWidget::preloadStickers(int yFrom, int yTill) {
 	auto &sets = shownSets();
-	for (int i = 0, l = sets.size(), k = 0; i < l; ++i) {
-		int count = sets[i].pack.size();
-		if (sets[i].externalLayout) {
-			accumulate_min(count, _columnCount);
+	const auto rowHeight = _singleSize.height();
+	if (rowHeight <= 0) {
+		return;
+	}
+	enumerateSectionsFrom(yFrom, [&](const SectionInfo &info) {
+		if (info.top >= yTill) {
+			return false;
 		}
-		for (int j = 0; j != count; ++j) {
-			if (++k > _columnCount * (_columnCount + 1)) break;
-
-			auto sticker = sets[i].pack.at(j);
-			if (!sticker || !sticker->sticker()) continue;
-
-			const auto goodThumb = sticker->hasGoodStickerThumb();
-			if (goodThumb) {
+		const auto &set = sets[info.section];
+		const auto count = set.externalLayout
+			? std::min(info.count, _columnCount)
+			: info.count;
+		const auto fromRow = floorclamp(yFrom - info.rowsTop, rowHeight, 0, info.rowsCount);
+		const auto tillRow = ceilclamp(yTill - info.rowsTop, rowHeight, 0, info.rowsCount);
+		const auto till = std::min(tillRow * _columnCount, count);
+		for (auto j = fromRow * _columnCount; j < till; ++j) {
+			const auto sticker = set.pack[j];
+			if (!sticker || !sticker->sticker()) {
+				continue;
+			}
+			if (sticker->hasGoodStickerThumb()) {
 				sticker->thumb->load();
 			} else {
 				sticker->automaticLoad(0);
 			}
 		}
-		if (k > _columnCount * (_columnCount + 1)) break;
-	}
-	if (_footer) {
-		_footer->preloadImages();
-	}
+		return true;
+	});
 }
 
 uint64 StickersListWidget::currentSet(int yOffset) const {
@@ -159,8 +159,30 @@ private:
 		int count = 0;
 	};
 
+	struct SectionsKey {
+		Section section = Section::Stickers;
+		int setsCount = 0;
+		int columnCount = 0;
+		int rowHeight = 0;
+		int megagroupBottom = 0;
+	};
+	friend inline bool operator==(
+			const SectionsKey &a,
+			const SectionsKey &b) {
+		return (a.section == b.section)
+			&& (a.setsCount == b.setsCount)
+			&& (a.columnCount == b.columnCount)
+			&& (a.rowHeight == b.rowHeight)
+			&& (a.megagroupBottom == b.megagroupBottom);
+	}
+
 	template <typename Callback>
 	bool enumerateSections(Callback callback) const;
+	template <typename Callback>
+	bool enumerateSectionsFrom(int yOffset, Callback callback) const;
+	SectionsKey sectionsKey() const;
+	void refreshSections() const;
+	const std::vector<SectionInfo> &sections() const;
 	SectionInfo sectionInfo(int section) const;
 	SectionInfo sectionInfoByOffset(int yOffset) const;
 
@@ -203,6 +225,7 @@ private:
 	const std::vector<Set> &shownSets() const;
 	int featuredRowHeight() const;
 	void readVisibleSets();
+	void preloadStickers(int yFrom, int yTill);
 
 	void paintFeaturedStickers(Painter &p, QRect clip);
 	void paintStickers(Painter &p, QRect clip);
@@ -266,6 +289,11 @@ private:
 	int _columnCount = 1;
 	QSize _singleSize;
 
+	// Layout of shownSets(), refreshed in countDesiredHeight()
+	// or when the key changes, for binary search by offset.
+	mutable std::vector<SectionInfo> _sections;
+	mutable SectionsKey _sectionsKey;
+
 	OverState _selected;
 	OverState _pressed;
 	QPoint _lastMousePosition;
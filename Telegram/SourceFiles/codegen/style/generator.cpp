@@ -29,6 +29,9 @@ namespace {
 constexpr int kErrorBadIconSize     = 861;
 constexpr int kErrorBadIconFormat   = 862;
 
+// Width of the 100x icon atlas rows, other scales are proportional.
+constexpr int kIconAtlasWidth = 512;
+
 // crc32 hash, taken somewhere from the internet
 
 class Crc32Table {
@@ -1175,9 +1178,14 @@ QByteArray iconMaskValueSize(int width, int height) {
 	return result;
 }
 
-QByteArray iconMaskValuePng(QString filepath) {
-	QByteArray result;
+struct IconMaskImages {
+	QImage png100x;
+	QImage png125x;
+	QImage png150x;
+	QImage png200x;
+};
 
+bool iconMaskImages(QString filepath, IconMaskImages &result) {
 	QFileInfo fileInfo(filepath);
 	auto directory = fileInfo.dir();
 	auto nameAndModifiers = fileInfo.fileName().split('-');
@@ -1190,48 +1198,81 @@ QByteArray iconMaskValuePng(QString filepath) {
 	png200x.setDevicePixelRatio(1.);
 	if (png100x.isNull()) {
 		common::logError(common::kErrorFileNotOpened, filepath + ".png") << "could not open icon file";
-		return result;
+		return false;
 	}
 	if (png200x.isNull()) {
 		common::logError(common::kErrorFileNotOpened, filepath + "@2x.png") << "could not open icon file";
-		return result;
+		return false;
 	}
 	if (png100x.format() != png200x.format()) {
 		common::logError(kErrorBadIconFormat, filepath + ".png") << "1x and 2x icons have different format";
-		return result;
+		return false;
 	}
 	if (png100x.width() * 2 != png200x.width() || png100x.height() * 2 != png200x.height()) {
 		common::logError(kErrorBadIconSize, filepath + ".png") << "bad icons size, 1x: " << png100x.width() << "x" << png100x.height() << ", 2x: " << png200x.width() << "x" << png200x.height();
-		return result;
+		return false;
 	}
 	for (auto modifierName : modifiers) {
 		if (auto modifier = GetModifier(modifierName)) {
 			modifier(png100x, png200x);
 		} else {
 			common::logError(common::kErrorInternal, filepath) << "modifier should be valid here, name: " << modifierName.toStdString();
-			return result;
+			return false;
+		}
+	}
+	result.png125x = png200x.scaled(structure::data::pxAdjust(png100x.width(), 5), structure::data::pxAdjust(png100x.height(), 5), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+	result.png150x = png200x.scaled(structure::data::pxAdjust(png100x.width(), 6), structure::data::pxAdjust(png100x.height(), 6), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+	result.png100x = std::move(png100x);
+	result.png200x = std::move(png200x);
+	return true;
+}
+
+// Packs all the images in rows of limited width and returns
+// the atlas encoded as PNG, filling the image rects in the atlas.
+QByteArray iconAtlasValue(const QVector<QImage> &images, int rowWidth, QVector<QRect> &rects) {
+	auto maxWidth = 0;
+	for (const auto &image : images) {
+		maxWidth = std::max(maxWidth, image.width());
+	}
+	const auto limit = std::max(maxWidth, rowWidth);
+
+	rects.clear();
+	rects.reserve(images.size());
+	auto x = 0, y = 0, rowHeight = 0, width = 0;
+	for (const auto &image : images) {
+		if (x + image.width() > limit) {
+			x = 0;
+			y += rowHeight;
+			rowHeight = 0;
 		}
+		rects.push_back(QRect(x, y, image.width(), image.height()));
+		x += image.width();
+		width = std::max(width, x);
+		rowHeight = std::max(rowHeight, image.height());
 	}
-	QImage png125x = png200x.scaled(structure::data::pxAdjust(png100x.width(), 5), structure::data::pxAdjust(png100x.height(), 5), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-	QImage png150x = png200x.scaled(structure::data::pxAdjust(png100x.width(), 6), structure::data::pxAdjust(png100x.height(), 6), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
 
-	QImage composed(png200x.width() + png100x.width(), png200x.height() + png150x.height(), png100x.format());
+	QImage atlas(width, y + rowHeight, QImage::Format_ARGB32);
 	{
-		QPainter p(&composed);
+		QPainter p(&atlas);
 		p.setCompositionMode(QPainter::CompositionMode_Source);
-		p.fillRect(0, 0, composed.width(), composed.height(), QColor(0, 0, 0, 255));
-		p.drawImage(0, 0, png200x);
-		p.drawImage(png200x.width(), 0, png100x);
-		p.drawImage(0, png200x.height(), png150x);
-		p.drawImage(png150x.width(), png200x.height(), png125x);
+		p.fillRect(0, 0, atlas.width(), atlas.height(), QColor(0, 0, 0, 255));
+		// Copy the mask pixels as they are, partial alpha included.
+		for (auto i = 0, count = images.size(); i != count; ++i) {
+			p.drawImage(rects[i].topLeft(), images[i]);
+		}
 	}
+	QByteArray result;
 	{
 		QBuffer buffer(&result);
-		composed.save(&buffer, "PNG");
+		atlas.save(&buffer, "PNG");
 	}
 	return result;
 }
 
+QString iconRectValue(const QRect &rect) {
+	return QString("QRect(%1, %2, %3, %4)").arg(rect.x()).arg(rect.y()).arg(rect.width()).arg(rect.height());
+}
+
 } // namespace
 
 bool Generator::writeIconValues() {
@@ -1239,26 +1280,55 @@ bool Generator::writeIconValues() {
 		return true;
 	}
 
+	auto atlasIndices = QVector<int>();
+	QVector<QImage> images100x, images125x, images150x, images200x;
 	for (auto i = iconMasks_.cbegin(), e = iconMasks_.cend(); i != e; ++i) {
 		QString filePath = i.key();
-		QByteArray maskData;
-		QImage png100x, png200x;
 		if (filePath.startsWith("size://")) {
 			QStringList dimensions = filePath.mid(7).split(',');
 			if (dimensions.size() < 2 || dimensions.at(0).toInt() <= 0 || dimensions.at(1).toInt() <= 0) {
 				common::logError(common::kErrorFileNotOpened, filePath) << "bad dimensions";
 				return false;
 			}
-			maskData = iconMaskValueSize(dimensions.at(0).toInt(), dimensions.at(1).toInt());
-		} else {
-			maskData = iconMaskValuePng(filePath);
+			auto maskData = iconMaskValueSize(dimensions.at(0).toInt(), dimensions.at(1).toInt());
+			source_->stream() << "const uchar iconMask" << i.value() << "Data[] = " << stringToBinaryArray(std::string(maskData.constData(), maskData.size())) << ";\n";
+			source_->stream() << "IconMask iconMask" << i.value() << "(iconMask" << i.value() << "Data);\n\n";
+			continue;
 		}
-		if (maskData.isEmpty()) {
+		auto images = IconMaskImages();
+		if (!iconMaskImages(filePath, images)) {
 			return false;
 		}
-		source_->stream() << "const uchar iconMask" << i.value() << "Data[] = " << stringToBinaryArray(std::string(maskData.constData(), maskData.size())) << ";\n";
-		source_->stream() << "IconMask iconMask" << i.value() << "(iconMask" << i.value() << "Data);\n\n";
+		atlasIndices.push_back(i.value());
+		images100x.push_back(std::move(images.png100x));
+		images125x.push_back(std::move(images.png125x));
+		images150x.push_back(std::move(images.png150x));
+		images200x.push_back(std::move(images.png200x));
 	}
+	if (atlasIndices.isEmpty()) {
+		return true;
+	}
+
+	// All the module icons of one scale are packed in a single atlas,
+	// so only one PNG is decoded at runtime for the current scale.
+	QVector<QRect> rects100x, rects125x, rects150x, rects200x;
+	const auto atlas100x = iconAtlasValue(images100x, kIconAtlasWidth, rects100x);
+	const auto atlas125x = iconAtlasValue(images125x, structure::data::pxAdjust(kIconAtlasWidth, 5), rects125x);
+	const auto atlas150x = iconAtlasValue(images150x, structure::data::pxAdjust(kIconAtlasWidth, 6), rects150x);
+	const auto atlas200x = iconAtlasValue(images200x, kIconAtlasWidth * 2, rects200x);
+	if (atlas100x.isEmpty() || atlas125x.isEmpty() || atlas150x.isEmpty() || atlas200x.isEmpty()) {
+		common::logError(common::kErrorInternal, basePath_) << "could not write icon atlas";
+		return false;
+	}
+	source_->stream() << "const uchar iconAtlas100xData[] = " << stringToBinaryArray(std::string(atlas100x.constData(), atlas100x.size())) << ";\n";
+	source_->stream() << "const uchar iconAtlas125xData[] = " << stringToBinaryArray(std::string(atlas125x.constData(), atlas125x.size())) << ";\n";
+	source_->stream() << "const uchar iconAtlas150xData[] = " << stringToBinaryArray(std::string(atlas150x.constData(), atlas150x.size())) << ";\n";
+	source_->stream() << "const uchar iconAtlas200xData[] = " << stringToBinaryArray(std::string(atlas200x.constData(), atlas200x.size())) << ";\n";
+	source_->stream() << "IconAtlas iconAtlas(iconAtlas100xData, iconAtlas125xData, iconAtlas150xData, iconAtlas200xData);\n\n";
+	for (auto i = 0, count = atlasIndices.size(); i != count; ++i) {
+		source_->stream() << "IconMask iconMask" << atlasIndices[i] << "(iconAtlas, " << iconRectValue(rects100x[i]) << ", " << iconRectValue(rects125x[i]) << ", " << iconRectValue(rects150x[i]) << ", " << iconRectValue(rects200x[i]) << ");\n";
+	}
+	source_->newline();
 	return true;
 }
 
@@ -649,6 +649,14 @@ bool DocumentData::loaded(FilePathResolveType type) const {
 				that->sticker()->img = ImagePtr(_data, _loader->imageFormat(), _loader->imagePixmap());
 			}
 			destroyLoaderDelayed();
+
+			// Start counting the waveform right away instead of
+			// waiting for the voice message to be painted.
+			if (const auto voice = that->voice()) {
+				if (voice->waveform.isEmpty()) {
+					Local::countVoiceWaveform(that);
+				}
+			}
 		}
 		_session->data().notifyDocumentLayoutChanged(this);
 	}
@@ -144,7 +144,7 @@ void PeerData::updateNameDelayed(
 		}
 	}
 	fillNames();
-	Notify::PeerUpdated().notify(update, true);
+	Notify::peerUpdatedNow(update);
 }
 
 std::unique_ptr<Ui::EmptyUserpic> PeerData::createEmptyUserpic() const {
@@ -61,6 +61,11 @@ void PhotoData::cancel() {
 	Auth().data().notifyPhotoLayoutChanged(this);
 }
 
+void PhotoData::stopLoading() {
+	full->stopLoading();
+	Auth().data().notifyPhotoLayoutChanged(this);
+}
+
 float64 PhotoData::progress() const {
 	if (uploading()) {
 		if (uploadingData->size > 0) {
@@ -27,6 +27,7 @@ public:
 	bool loading() const;
 	bool displayLoading() const;
 	void cancel();
+	void stopLoading();
 	float64 progress() const;
 	int32 loadOffset() const;
 	bool uploading() const;
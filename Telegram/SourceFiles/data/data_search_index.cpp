@@ -0,0 +1,132 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "data/data_search_index.h"
+
+#include "history/history_item.h"
+
+namespace Data {
+namespace {
+
+constexpr auto kMaxQueryResults = 100;
+
+} // namespace
+
+bool SearchIndex::HasWordWithPrefix(
+		const ItemWords &words,
+		const QString &prefix) {
+	for (const auto &word : words) {
+		if (word->first.startsWith(prefix)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void SearchIndex::registerMessage(not_null<HistoryItem*> item) {
+	unregisterMessage(item);
+
+	auto words = TextUtilities::PrepareSearchWords(item->originalText().text);
+	words.removeDuplicates();
+	if (words.isEmpty()) {
+		return;
+	}
+	auto itemWords = ItemWords();
+	itemWords.reserve(words.size());
+	for (const auto &word : words) {
+		const auto i = _words.emplace(
+			word,
+			std::unordered_set<HistoryItem*>()).first;
+		i->second.emplace(item.get());
+		itemWords.push_back(i);
+	}
+	_itemWords.emplace(item.get(), std::move(itemWords));
+}
+
+void SearchIndex::unregisterMessage(not_null<const HistoryItem*> item) {
+	const auto i = _itemWords.find(item.get());
+	if (i == end(_itemWords)) {
+		return;
+	}
+	const auto key = const_cast<HistoryItem*>(item.get());
+	for (const auto word : i->second) {
+		word->second.erase(key);
+		if (word->second.empty()) {
+			_words.erase(word);
+		}
+	}
+	_itemWords.erase(i);
+}
+
+std::vector<not_null<HistoryItem*>> SearchIndex::query(
+		const QString &query,
+		History *history) const {
+	const auto started = getms(true);
+	auto words = TextUtilities::PrepareSearchWords(query);
+	if (words.isEmpty()) {
+		return {};
+	}
+
+	// Collect candidates by the longest word, it has the least matches.
+	const auto longest = ranges::max_element(
+		words,
+		std::less<>(),
+		[](const QString &word) { return word.size(); });
+	const auto driver = *longest;
+	words.erase(longest);
+
+	auto result = std::vector<not_null<HistoryItem*>>();
+	for (auto i = _words.lower_bound(driver); i != end(_words); ++i) {
+		if (!i->first.startsWith(driver)) {
+			break;
+		}
+		for (const auto item : i->second) {
+			if (history && item->history() != history) {
+				continue;
+			}
+			result.push_back(item);
+		}
+	}
+	ranges::sort(result);
+	result.erase(std::unique(begin(result), end(result)), end(result));
+	result.erase(ranges::remove_if(result, [&](not_null<HistoryItem*> item) {
+		const auto &itemWords = _itemWords.find(item.get())->second;
+		for (const auto &word : words) {
+			if (!HasWordWithPrefix(itemWords, word)) {
+				return true;
+			}
+		}
+		return false;
+	}), end(result));
+
+	ranges::sort(result, [](
+			not_null<HistoryItem*> a,
+			not_null<HistoryItem*> b) {
+		return (a->date() > b->date())
+			|| (a->date() == b->date() && a->id > b->id);
+	});
+	if (result.size() > kMaxQueryResults) {
+		result.erase(begin(result) + kMaxQueryResults, end(result));
+	}
+
+	logQueryStats(result.size(), getms(true) - started);
+	return result;
+}
+
+void SearchIndex::logQueryStats(int found, TimeMs duration) const {
+	++_queriesCount;
+	_queriesDuration += duration;
+	DEBUG_LOG(("Search Index: found %1 in %2 ms (average %3 ms), "
+		"%4 words in %5 messages."
+		).arg(found
+		).arg(duration
+		).arg(_queriesDuration / _queriesCount
+		).arg(_words.size()
+		).arg(_itemWords.size()));
+}
+
+} // namespace Data
@@ -0,0 +1,46 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "data/data_types.h"
+
+namespace Data {
+
+// Word index of the texts of all messages loaded in memory, so that
+// search results can be shown before the server responds.
+class SearchIndex {
+public:
+	void registerMessage(not_null<HistoryItem*> item);
+	void unregisterMessage(not_null<const HistoryItem*> item);
+
+	// Messages containing all the query words as word prefixes,
+	// the newest first. Searches only in history if it is not null.
+	std::vector<not_null<HistoryItem*>> query(
+		const QString &query,
+		History *history = nullptr) const;
+
+private:
+	// Words are kept sorted for the prefix search. Items refer to their
+	// words by the map iterators, a word is erased with its last item.
+	using Words = std::map<QString, std::unordered_set<HistoryItem*>>;
+	using ItemWords = std::vector<Words::iterator>;
+
+	static bool HasWordWithPrefix(
+		const ItemWords &words,
+		const QString &prefix);
+	void logQueryStats(int found, TimeMs duration) const;
+
+	Words _words;
+	std::unordered_map<const HistoryItem*, ItemWords> _itemWords;
+
+	mutable int _queriesCount = 0;
+	mutable TimeMs _queriesDuration = 0;
+
+};
+
+} // namespace Data
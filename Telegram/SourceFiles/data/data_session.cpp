@@ -374,6 +374,7 @@ rpl::producer<not_null<HistoryItem*>> Session::animationPlayInlineRequest() cons
 void Session::notifyItemRemoved(not_null<const HistoryItem*> item) {
 	_itemRemoved.fire_copy(item);
 	groups().unregisterMessage(item);
+	searchIndex().unregisterMessage(item);
 }
 
 rpl::producer<not_null<const HistoryItem*>> Session::itemRemoved() const {
@@ -10,6 +10,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "chat_helpers/stickers.h"
 #include "dialogs/dialogs_key.h"
 #include "data/data_groups.h"
+#include "data/data_search_index.h"
 #include "base/timer.h"
 
 class HistoryItem;
@@ -413,6 +414,12 @@ public:
 	const Groups &groups() const {
 		return _groups;
 	}
+	SearchIndex &searchIndex() {
+		return _searchIndex;
+	}
+	const SearchIndex &searchIndex() const {
+		return _searchIndex;
+	}
 
 private:
 	void suggestStartExport();
@@ -604,6 +611,7 @@ private:
 	base::flat_map<FeedId, std::unique_ptr<Feed>> _feeds;
 	rpl::variable<FeedId> _defaultFeedId = FeedId();
 	Groups _groups;
+	SearchIndex _searchIndex;
 	std::map<
 		not_null<const HistoryItem*>,
 		std::vector<not_null<ViewElement*>>> _views;
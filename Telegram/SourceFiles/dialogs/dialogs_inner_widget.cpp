@@ -41,6 +41,7 @@ namespace {
 
 constexpr auto kHashtagResultsLimit = 5;
 constexpr auto kStartReorderThreshold = 30;
+constexpr auto kKeepRowCachesScreens = 2;
 
 } // namespace
 
@@ -117,6 +118,7 @@ DialogsInner::DialogsInner(QWidget *parent, not_null<Window::Controller*> contro
 	subscribe(Window::Theme::Background(), [=](const Window::Theme::BackgroundUpdate &data) {
 		if (data.paletteChanged()) {
 			Dialogs::Layout::clearUnreadBadgesCache();
+			Dialogs::Layout::clearRowCaches();
 		}
 	});
 
@@ -1771,6 +1773,7 @@ void DialogsInner::visibleTopBottomUpdated(
 	_visibleTop = visibleTop;
 	_visibleBottom = visibleBottom;
 	loadPeerPhotos();
+	clearFarRowCaches();
 	if (_visibleTop + PreloadHeightsCount * (_visibleBottom - _visibleTop) >= height()) {
 		if (_loadMoreCallback) {
 			_loadMoreCallback();
@@ -1906,6 +1909,12 @@ bool DialogsInner::searchReceived(
 	} else {
 		_searchedCount = fullCount;
 	}
+	if (type == DialogsSearchFromStart
+		|| type == DialogsSearchPeerFromStart
+		|| type == DialogsSearchMigratedFromStart) {
+		const auto complete = (messages.size() >= fullCount);
+		mergeLocalSearchResults(type, complete ? 0 : lastDateFound);
+	}
 	if (_waitingForSearch
 		&& (!_searchResults.empty()
 			|| !_searchInMigrated
@@ -1917,6 +1926,84 @@ bool DialogsInner::searchReceived(
 	return lastDateFound != 0;
 }
 
+void DialogsInner::searchLocal() {
+	if (!_waitingForSearch || !_searchResults.empty()) {
+		return;
+	}
+	const auto history = _searchInChat.history();
+	if (_searchInChat && !history) {
+		return;
+	}
+	for (const auto item : localSearchResults(history)) {
+		_searchResults.push_back(
+			std::make_unique<Dialogs::FakeRow>(_searchInChat, item));
+	}
+	_searchedCount = int(_searchResults.size());
+	if (_searchInMigrated) {
+		for (const auto item : localSearchResults(_searchInMigrated)) {
+			_searchResults.push_back(
+				std::make_unique<Dialogs::FakeRow>(_searchInChat, item));
+		}
+		_searchedMigratedCount = int(_searchResults.size()) - _searchedCount;
+	}
+	if (!_searchResults.empty()) {
+		refresh();
+	}
+}
+
+std::vector<not_null<HistoryItem*>> DialogsInner::localSearchResults(
+		History *history) const {
+	auto result = Auth().data().searchIndex().query(_filter, history);
+	if (_searchFromUser) {
+		result.erase(ranges::remove_if(result, [&](
+				not_null<HistoryItem*> item) {
+			return (item->from() != _searchFromUser);
+		}), end(result));
+	}
+	return result;
+}
+
+void DialogsInner::mergeLocalSearchResults(
+		DialogsSearchRequestType type,
+		TimeId minDate) {
+	const auto history = (type == DialogsSearchMigratedFromStart)
+		? _searchInMigrated
+		: _searchInChat.history();
+	if (_searchInChat && !history) {
+		return;
+	}
+
+	// Server results are newest first, so only local ones newer than the
+	// end of the received page are added, older ones come with next pages.
+	using Row = std::unique_ptr<Dialogs::FakeRow>;
+	const auto itemOfRow = [](const Row &row) {
+		return row->item();
+	};
+	auto merged = 0;
+	for (const auto item : localSearchResults(history)) {
+		if (minDate && item->date() <= minDate) {
+			break;
+		}
+		if (ranges::find(_searchResults, item, itemOfRow)
+			!= end(_searchResults)) {
+			continue;
+		}
+		const auto position = ranges::find_if(_searchResults, [&](
+				const Row &row) {
+			return (row->item()->date() < item->date());
+		});
+		_searchResults.insert(
+			position,
+			std::make_unique<Dialogs::FakeRow>(_searchInChat, item));
+		++merged;
+	}
+	if (type == DialogsSearchMigratedFromStart) {
+		_searchedMigratedCount += merged;
+	} else {
+		_searchedCount += merged;
+	}
+}
+
 void DialogsInner::peerSearchReceived(
 		const QString &query,
 		const QVector<MTPPeer> &my,
@@ -2345,6 +2432,31 @@ void DialogsInner::selectSkipPage(int32 pixels, int32 direction) {
 	update();
 }
 
+void DialogsInner::clearFarRowCaches() {
+	const auto keep = kKeepRowCachesScreens * (_visibleBottom - _visibleTop);
+	const auto top = _visibleTop - keep;
+	const auto bottom = _visibleBottom + keep;
+	const auto far = [&](int y) {
+		return (y + st::dialogsRowHeight <= top) || (y >= bottom);
+	};
+	if (_state == State::Default) {
+		const auto skip = dialogsOffset();
+		for (const auto row : *shownDialogs()) {
+			if (far(skip + row->pos() * st::dialogsRowHeight)) {
+				row->clearCache();
+			}
+		}
+	} else if (_state == State::Filtered) {
+		auto y = filteredOffset();
+		for (const auto row : _filterResults) {
+			if (far(y)) {
+				row->clearCache();
+			}
+			y += st::dialogsRowHeight;
+		}
+	}
+}
+
 void DialogsInner::loadPeerPhotos() {
 	if (!parentWidget()) return;
 
@@ -41,6 +41,7 @@ public:
 		const QVector<MTPMessage> &result,
 		DialogsSearchRequestType type,
 		int fullCount);
+	void searchLocal();
 	void peerSearchReceived(
 		const QString &query,
 		const QVector<MTPPeer> &my,
@@ -171,6 +172,7 @@ private:
 	}
 	void updateSelected(QPoint localPos);
 	void loadPeerPhotos();
+	void clearFarRowCaches();
 	void setImportantSwitchPressed(bool pressed);
 	void setPressed(Dialogs::Row *pressed);
 	void setHashtagPressed(int pressed);
@@ -267,6 +269,11 @@ private:
 
 	void clearSelection();
 	void clearSearchResults(bool clearPeerSearchResults = true);
+	std::vector<not_null<HistoryItem*>> localSearchResults(
+		History *history) const;
+	void mergeLocalSearchResults(
+		DialogsSearchRequestType type,
+		TimeId minDate);
 	void updateSelectedRow(Dialogs::Key key = Dialogs::Key());
 
 	Dialogs::IndexedList *shownDialogs() const;
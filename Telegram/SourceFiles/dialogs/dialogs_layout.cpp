@@ -33,23 +33,24 @@ void paintRowTopRight(Painter &p, const QString &text, QRect &rectForName, bool
 	p.drawText(rectForName.left() + rectForName.width() + st::dialogsDateSkip, rectForName.top() + st::msgNameFont->height - st::msgDateFont->descent, text);
 }
 
-void paintRowDate(Painter &p, QDateTime date, QRect &rectForName, bool active, bool selected) {
+QString RowDateText(QDateTime date) {
 	auto now = QDateTime::currentDateTime();
 	auto lastTime = date;
 	auto nowDate = now.date();
 	auto lastDate = lastTime.date();
 
-	QString dt;
 	bool wasSameDay = (lastDate == nowDate);
 	bool wasRecently = qAbs(lastTime.secsTo(now)) < kRecentlyInSeconds;
 	if (wasSameDay || wasRecently) {
-		dt = lastTime.toString(cTimeFormat());
+		return lastTime.toString(cTimeFormat());
 	} else if (lastDate.year() == nowDate.year() && lastDate.weekNumber() == nowDate.weekNumber()) {
-		dt = langDayOfWeek(lastDate);
-	} else {
-		dt = lastDate.toString(qsl("d.MM.yy"));
+		return langDayOfWeek(lastDate);
 	}
-	paintRowTopRight(p, dt, rectForName, active, selected);
+	return lastDate.toString(qsl("d.MM.yy"));
+}
+
+void paintRowDate(Painter &p, QDateTime date, QRect &rectForName, bool active, bool selected) {
+	paintRowTopRight(p, RowDateText(date), rectForName, active, selected);
 }
 
 enum class Flag {
@@ -330,6 +331,37 @@ QImage colorizeCircleHalf(UnreadBadgeSizeData *data, int size, int half, int xof
 	return result;
 }
 
+// Bumped to drop all the cached row pictures at once.
+int RowCacheVersion = 0;
+
+const Data::Draft *RowCloudDraft(
+		History *history,
+		HistoryItem *item,
+		int unreadCount,
+		bool unreadMark) {
+	if (history && (!item || (!unreadCount && !unreadMark))) {
+		// Draw item, if there are unread messages.
+		if (const auto draft = history->cloudDraft()) {
+			if (!Data::draftIsNull(draft)) {
+				return draft;
+			}
+		}
+	}
+	return nullptr;
+}
+
+QDateTime RowDisplayDate(HistoryItem *item, const Data::Draft *cloudDraft) {
+	if (item) {
+		if (cloudDraft) {
+			return (item->date() > cloudDraft->date)
+				? ItemDateTime(item)
+				: ParseDateTime(cloudDraft->date);
+		}
+		return ItemDateTime(item);
+	}
+	return cloudDraft ? ParseDateTime(cloudDraft->date) : QDateTime();
+}
+
 } // namepsace
 
 const style::icon *ChatTypeIcon(
@@ -430,6 +462,100 @@ void RowPainter::paint(
 		bool selected,
 		bool onlyBackground,
 		TimeMs ms) {
+	const auto history = row->history();
+	const auto cacheable = !onlyBackground
+		&& history
+		&& !row->hasRipple()
+		&& !history->hasSendAction();
+	if (!cacheable) {
+		paintContent(p, row, fullWidth, active, selected, onlyBackground, ms);
+		return;
+	}
+	auto &cache = row->_cache;
+	const auto key = cacheKey(row, fullWidth, active, selected);
+	if (!cache || cache->key != key) {
+		if (!cache) {
+			cache = std::make_unique<RowCache>();
+		}
+		auto image = QImage(
+			QSize(fullWidth, st::dialogsRowHeight) * cIntRetinaFactor(),
+			QImage::Format_ARGB32_Premultiplied);
+		image.setDevicePixelRatio(cRetinaFactor());
+		{
+			Painter q(&image);
+			paintContent(q, row, fullWidth, active, selected, false, ms);
+		}
+		cache->pixmap = App::pixmapFromImageInPlace(std::move(image));
+
+		// Painting fills the text caches, so the key could change.
+		cache->key = cacheKey(row, fullWidth, active, selected);
+	}
+	p.drawPixmap(0, 0, cache->pixmap);
+}
+
+RowCacheKey RowPainter::cacheKey(
+		not_null<const Row*> row,
+		int fullWidth,
+		bool active,
+		bool selected) {
+	const auto entry = row->entry();
+	const auto history = row->history();
+	const auto unreadCount = entry->chatListUnreadCount();
+	const auto unreadMark = entry->chatListUnreadMark();
+	const auto item = entry->chatsListItem();
+	const auto cloudDraft = RowCloudDraft(history, item, unreadCount, unreadMark);
+	const auto displayDate = RowDisplayDate(item, cloudDraft);
+	const auto from = history
+		? (history->peer->migrateTo()
+			? history->peer->migrateTo()
+			: history->peer.get())
+		: nullptr;
+
+	auto result = RowCacheKey();
+	result.version = RowCacheVersion;
+	result.width = fullWidth;
+	result.active = active;
+	result.selected = selected;
+	result.unreadCount = unreadCount;
+	result.unreadMark = unreadMark;
+	result.unreadMuted = entry->chatListMutedBadge();
+	result.unreadMentions = history ? history->hasUnreadMentions() : false;
+	result.pinned = entry->isPinnedDialog();
+	result.favorite = entry->isFavoriteDialog();
+	result.promoted = entry->useProxyPromotion();
+	result.item = item;
+	result.textCachedFor = entry->textCachedFor;
+	if (item) {
+		result.itemId = item->id;
+		result.itemUnread = item->unread();
+		result.itemMediaUnread = item->isMediaUnread() && item->mentionsMe();
+	}
+	result.draft = cloudDraft;
+	if (cloudDraft) {
+		result.draftSaveRequestId = cloudDraft->saveRequestId;
+		result.draftTextCached = !history->cloudDraftTextCache.isEmpty();
+	}
+	if (displayDate.isValid()) {
+		result.date = RowDateText(displayDate);
+	}
+	if (from) {
+		result.from = from;
+		result.nameVersion = from->nameVersion;
+		result.name = &from->dialogName();
+		result.verified = from->isVerified();
+		result.userpic = from->userpicUniqueKey();
+	}
+	return result;
+}
+
+void RowPainter::paintContent(
+		Painter &p,
+		not_null<const Row*> row,
+		int fullWidth,
+		bool active,
+		bool selected,
+		bool onlyBackground,
+		TimeMs ms) {
 	const auto entry = row->entry();
 	const auto history = row->history();
 	const auto peer = history ? history->peer.get() : nullptr;
@@ -437,28 +563,8 @@ void RowPainter::paint(
 	const auto unreadMark = entry->chatListUnreadMark();
 	const auto unreadMuted = entry->chatListMutedBadge();
 	const auto item = entry->chatsListItem();
-	const auto cloudDraft = [&]() -> const Data::Draft*{
-		if (history && (!item || (!unreadCount && !unreadMark))) {
-			// Draw item, if there are unread messages.
-			if (const auto draft = history->cloudDraft()) {
-				if (!Data::draftIsNull(draft)) {
-					return draft;
-				}
-			}
-		}
-		return nullptr;
-	}();
-	const auto displayDate = [item, cloudDraft] {
-		if (item) {
-			if (cloudDraft) {
-				return (item->date() > cloudDraft->date)
-					? ItemDateTime(item)
-					: ParseDateTime(cloudDraft->date);
-			}
-			return ItemDateTime(item);
-		}
-		return cloudDraft ? ParseDateTime(cloudDraft->date) : QDateTime();
-	}();
+	const auto cloudDraft = RowCloudDraft(history, item, unreadCount, unreadMark);
+	const auto displayDate = RowDisplayDate(item, cloudDraft);
 
 	const auto from = history
 		? (history->peer->migrateTo()
@@ -713,6 +819,10 @@ void paintImportantSwitch(Painter &p, Mode current, int fullWidth, bool selected
 	}
 }
 
+void clearRowCaches() {
+	++RowCacheVersion;
+}
+
 void clearUnreadBadgesCache() {
 	if (unreadBadgeStyle) {
 		for (auto &data : unreadBadgeStyle->sizes) {
@@ -15,6 +15,7 @@ namespace Dialogs {
 
 class Row;
 class FakeRow;
+struct RowCacheKey;
 
 namespace Layout {
 
@@ -51,6 +52,21 @@ public:
 		int fullWidth,
 		bool textUpdated);
 
+private:
+	static void paintContent(
+		Painter &p,
+		not_null<const Row*> row,
+		int fullWidth,
+		bool active,
+		bool selected,
+		bool onlyBackground,
+		TimeMs ms);
+	static RowCacheKey cacheKey(
+		not_null<const Row*> row,
+		int fullWidth,
+		bool active,
+		bool selected);
+
 };
 
 void paintImportantSwitch(
@@ -90,6 +106,7 @@ void paintUnreadCount(
 	int *outUnreadWidth = nullptr);
 
 void clearUnreadBadgesCache();
+void clearRowCaches();
 
 } // namespace Layout
 } // namespace Dialogs
@@ -40,6 +40,34 @@ void RippleRow::paintRipple(Painter &p, int x, int y, int outerWidth, TimeMs ms,
 	}
 }
 
+bool operator==(const RowCacheKey &a, const RowCacheKey &b) {
+	return (a.version == b.version)
+		&& (a.width == b.width)
+		&& (a.active == b.active)
+		&& (a.selected == b.selected)
+		&& (a.unreadCount == b.unreadCount)
+		&& (a.unreadMark == b.unreadMark)
+		&& (a.unreadMuted == b.unreadMuted)
+		&& (a.unreadMentions == b.unreadMentions)
+		&& (a.pinned == b.pinned)
+		&& (a.favorite == b.favorite)
+		&& (a.promoted == b.promoted)
+		&& (a.item == b.item)
+		&& (a.textCachedFor == b.textCachedFor)
+		&& (a.itemId == b.itemId)
+		&& (a.itemUnread == b.itemUnread)
+		&& (a.itemMediaUnread == b.itemMediaUnread)
+		&& (a.draft == b.draft)
+		&& (a.draftSaveRequestId == b.draftSaveRequestId)
+		&& (a.draftTextCached == b.draftTextCached)
+		&& (a.from == b.from)
+		&& (a.nameVersion == b.nameVersion)
+		&& (a.name == b.name)
+		&& (a.verified == b.verified)
+		&& (a.userpic == b.userpic)
+		&& (a.date == b.date);
+}
+
 uint64 Row::sortKey() const {
 	return _id.entry()->sortKeyInChatList();
 }
@@ -13,6 +13,10 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 class History;
 class HistoryItem;
 
+namespace Data {
+struct Draft;
+} // namespace Data
+
 namespace Ui {
 class RippleAnimation;
 } // namespace Ui
@@ -31,12 +35,53 @@ public:
 	void stopLastRipple();
 
 	void paintRipple(Painter &p, int x, int y, int outerWidth, TimeMs ms, const QColor *colorOverride = nullptr) const;
+	bool hasRipple() const {
+		return (_ripple != nullptr);
+	}
 
 private:
 	mutable std::unique_ptr<Ui::RippleAnimation> _ripple;
 
 };
 
+// Everything a cached history row picture depends on.
+struct RowCacheKey {
+	int version = 0;
+	int width = 0;
+	bool active = false;
+	bool selected = false;
+	int unreadCount = 0;
+	bool unreadMark = false;
+	bool unreadMuted = false;
+	bool unreadMentions = false;
+	bool pinned = false;
+	bool favorite = false;
+	bool promoted = false;
+	const HistoryItem *item = nullptr;
+	const HistoryItem *textCachedFor = nullptr;
+	MsgId itemId = 0;
+	bool itemUnread = false;
+	bool itemMediaUnread = false;
+	const Data::Draft *draft = nullptr;
+	mtpRequestId draftSaveRequestId = 0;
+	bool draftTextCached = false;
+	QString date;
+	const PeerData *from = nullptr;
+	int nameVersion = 0;
+	const Text *name = nullptr;
+	bool verified = false;
+	StorageKey userpic;
+};
+bool operator==(const RowCacheKey &a, const RowCacheKey &b);
+inline bool operator!=(const RowCacheKey &a, const RowCacheKey &b) {
+	return !(a == b);
+}
+
+struct RowCache {
+	RowCacheKey key;
+	QPixmap pixmap;
+};
+
 class List;
 class Row : public RippleRow {
 public:
@@ -66,16 +111,22 @@ public:
 	}
 	uint64 sortKey() const;
 
+	void clearCache() const {
+		_cache = nullptr;
+	}
+
 	// for any attached data, for example View in contacts list
 	void *attached = nullptr;
 
 private:
 	friend class List;
+	friend class Layout::RowPainter;
 
 	Key _id;
 	Row *_prev = nullptr;
 	Row *_next = nullptr;
 	int _pos = 0;
+	mutable std::unique_ptr<RowCache> _cache;
 
 };
 
@@ -598,6 +598,7 @@ bool DialogsWidget::onSearchMessages(bool searchCache) {
 				rpcFail(&DialogsWidget::searchFailed, DialogsSearchFromStart));
 		}
 		_searchQueries.insert(_searchRequest, _searchQuery);
+		_inner->searchLocal();
 	}
 	if (searchForPeersRequired(q)) {
 		if (searchCache) {
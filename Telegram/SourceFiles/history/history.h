@@ -265,6 +265,9 @@ public:
 
 	bool mySendActionUpdated(SendAction::Type type, bool doing);
 	bool paintSendAction(Painter &p, int x, int y, int availableWidth, int outerWidth, style::color color, TimeMs ms);
+	bool hasSendAction() const {
+		return static_cast<bool>(_sendActionAnimation);
+	}
 
 	// Interface for Histories
 	bool updateSendActionNeedsAnimating(TimeMs ms, bool force = false);
@@ -416,10 +416,21 @@ void HistoryPhoto::draw(Painter &p, const QRect &r, TextSelection selection, Tim
 		auto roundRadius = inWebPage ? ImageRoundRadius::Small : ImageRoundRadius::Large;
 		auto roundCorners = inWebPage ? RectPart::AllCorners : ((isBubbleTop() ? (RectPart::TopLeft | RectPart::TopRight) : RectPart::None)
 			| ((isBubbleBottom() && _caption.isEmpty()) ? (RectPart::BottomLeft | RectPart::BottomRight) : RectPart::None));
-		const auto pix = loaded
-			? _data->full->pixSingle(_pixw, _pixh, paintw, painth, roundRadius, roundCorners)
-			: _data->thumb->pixBlurredSingle(_pixw, _pixh, paintw, painth, roundRadius, roundCorners);
-		p.drawPixmap(rthumb.topLeft(), pix);
+		const auto ready = loaded
+			&& _data->full->pixSingleReady(_pixw, _pixh, paintw, painth, roundRadius, roundCorners);
+		const auto last = (loaded && !ready)
+			? _data->full->pixSingleLast(roundRadius, roundCorners)
+			: nullptr;
+		if (last) {
+			// Scale the previous size while the new one is prepared.
+			PainterHighQualityEnabler hq(p);
+			p.drawPixmap(rthumb, *last);
+		} else {
+			const auto pix = ready
+				? _data->full->pixSingle(_pixw, _pixh, paintw, painth, roundRadius, roundCorners)
+				: _data->thumb->pixBlurredSingle(_pixw, _pixh, paintw, painth, roundRadius, roundCorners);
+			p.drawPixmap(rthumb.topLeft(), pix);
+		}
 		if (selected) {
 			App::complexOverlayRect(p, rthumb, roundRadius, roundCorners);
 		}
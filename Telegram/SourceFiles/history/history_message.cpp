@@ -983,6 +983,7 @@ void HistoryMessage::setText(const TextWithEntities &textWithEntities) {
 		_textWidth = -1;
 		_textHeight = 0;
 	}
+	Auth().data().searchIndex().registerMessage(this);
 }
 
 void HistoryMessage::setEmptyText() {
@@ -990,6 +991,7 @@ void HistoryMessage::setEmptyText() {
 		st::messageTextStyle,
 		{ QString(), EntitiesInText() },
 		Ui::ItemTextOptions(this));
+	Auth().data().searchIndex().unregisterMessage(this);
 
 	_textWidth = -1;
 	_textHeight = 0;
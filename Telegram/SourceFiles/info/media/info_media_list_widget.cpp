@@ -43,6 +43,7 @@ constexpr auto kPreloadIfLessThanScreens = 2;
 constexpr auto kPreloadedScreensCountFull
 	= kPreloadedScreensCount + 1 + kPreloadedScreensCount;
 constexpr auto kMediaCountForSearch = 10;
+constexpr auto kHeavyLayoutsKeepScreens = 2;
 
 UniversalMsgId GetUniversalId(FullMsgId itemId) {
 	return (itemId.channel != 0)
@@ -65,6 +66,7 @@ struct ListWidget::Context {
 	not_null<SelectedMap*> selected;
 	not_null<SelectedMap*> dragSelected;
 	DragSelectAction dragSelectAction;
+	not_null<base::flat_set<UniversalMsgId>*> heavyLayouts;
 };
 
 class ListWidget::Section {
@@ -397,6 +399,7 @@ void ListWidget::Section::paint(
 				itemSelection(item, context),
 				&localContext);
 			p.translate(-rect.topLeft());
+			context.heavyLayouts->emplace(it->first);
 		}
 	}
 }
@@ -607,6 +610,7 @@ void ListWidget::restart() {
 	_overLayout = nullptr;
 	_sections.clear();
 	_layouts.clear();
+	_heavyLayouts.clear();
 
 	_universalAroundId = kDefaultAroundId;
 	_idsLimit = kMinimalIdsLimit;
@@ -1010,6 +1014,7 @@ void ListWidget::visibleTopBottomUpdated(
 	_visibleBottom = visibleBottom;
 
 	checkMoveToOtherViewer();
+	clearHeavyLayouts();
 }
 
 void ListWidget::checkMoveToOtherViewer() {
@@ -1123,7 +1128,8 @@ void ListWidget::paintEvent(QPaintEvent *e) {
 		Layout::PaintContext(ms, hasSelectedItems()),
 		&_selected,
 		&_dragSelected,
-		_dragSelectAction
+		_dragSelectAction,
+		&_heavyLayouts
 	};
 	for (auto it = fromSectionIt; it != tillSectionIt; ++it) {
 		auto top = it->top();
@@ -2083,6 +2089,35 @@ void ListWidget::clearStaleLayouts() {
 	}
 }
 
+void ListWidget::clearHeavyLayouts() {
+	const auto visibleHeight = (_visibleBottom - _visibleTop);
+	if (visibleHeight <= 0) {
+		return;
+	}
+
+	// Layouts keep only their text when far from the visible area,
+	// the pixmaps are prepared again when they are painted next time.
+	const auto keep = kHeavyLayoutsKeepScreens * visibleHeight;
+	const auto keepTop = _visibleTop - keep;
+	const auto keepBottom = _visibleBottom + keep;
+	for (auto i = _heavyLayouts.begin(); i != _heavyLayouts.end();) {
+		const auto universalId = *i;
+		if (const auto found = findItemById(universalId)) {
+			const auto &geometry = found->geometry;
+			if (geometry.y() < keepBottom
+				&& geometry.y() + geometry.height() > keepTop) {
+				++i;
+				continue;
+			}
+		}
+		const auto layout = _layouts.find(universalId);
+		if (layout != _layouts.end()) {
+			layout->second.item->clearHeavyPart();
+		}
+		i = _heavyLayouts.erase(i);
+	}
+}
+
 auto ListWidget::findSectionByItem(
 		UniversalMsgId universalId) -> std::vector<Section>::iterator {
 	return ranges::lower_bound(
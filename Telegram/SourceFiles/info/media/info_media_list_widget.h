@@ -223,6 +223,7 @@ private:
 
 	void markLayoutsStale();
 	void clearStaleLayouts();
+	void clearHeavyLayouts();
 	std::vector<Section>::iterator findSectionByItem(
 		UniversalMsgId universalId);
 	std::vector<Section>::iterator findSectionAfterTop(int top);
@@ -282,6 +283,9 @@ private:
 	std::map<UniversalMsgId, CachedItem> _layouts;
 	std::vector<Section> _sections;
 
+	// Painted layouts that may hold prepared pixmaps.
+	base::flat_set<UniversalMsgId> _heavyLayouts;
+
 	int _visibleTop = 0;
 	int _visibleBottom = 0;
 	ScrollTopState _scrollTopState;
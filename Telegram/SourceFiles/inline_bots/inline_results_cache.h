@@ -0,0 +1,79 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+namespace InlineBots {
+
+// Results are kept for the cache_time the bot asked for, but not less
+// than a minute, so that editing the query shows them instantly.
+constexpr auto kResultsCacheMinLifetime = TimeMs(60 * 1000);
+constexpr auto kResultsCacheLimit = 32;
+
+// Entry must have "TimeMs expires" and "TimeMs used" fields.
+template <typename Entry>
+using ResultsCache = std::map<QString, std::unique_ptr<Entry>>;
+
+inline TimeMs ResultsCacheExpires(int cacheTime) {
+	return getms(true) + std::max(
+		cacheTime * TimeMs(1000),
+		kResultsCacheMinLifetime);
+}
+
+template <typename Entry>
+bool ResultsCacheEntryExpired(const Entry &entry) {
+	return (entry.expires <= getms(true));
+}
+
+template <typename Entry>
+Entry *FreshResultsCacheEntry(
+		const ResultsCache<Entry> &cache,
+		const QString &query) {
+	const auto i = cache.find(query);
+	return (i == cache.cend() || ResultsCacheEntryExpired(*i->second))
+		? nullptr
+		: i->second.get();
+}
+
+// Removes the expired entries and the least recently used ones above
+// the limit, except for the shown one. Calls deleteUnusedLayouts()
+// before destroying any results.
+template <typename Entry, typename Callback>
+void TrimResultsCache(
+		ResultsCache<Entry> &cache,
+		const Entry *shown,
+		Callback &&deleteUnusedLayouts) {
+	const auto now = getms(true);
+	auto removing = std::vector<QString>();
+	auto left = std::vector<std::pair<TimeMs, QString>>();
+	for (const auto &[query, entry] : cache) {
+		if (entry.get() == shown) {
+			continue;
+		} else if (entry->expires <= now) {
+			removing.push_back(query);
+		} else {
+			left.emplace_back(entry->used, query);
+		}
+	}
+	const auto tooMany = int(cache.size() - removing.size())
+		- kResultsCacheLimit;
+	if (tooMany > 0) {
+		ranges::sort(left);
+		for (auto i = 0; i != tooMany && i != int(left.size()); ++i) {
+			removing.push_back(left[i].second);
+		}
+	}
+	if (removing.empty()) {
+		return;
+	}
+	deleteUnusedLayouts();
+	for (const auto &query : removing) {
+		cache.erase(query);
+	}
+}
+
+} // namespace InlineBots
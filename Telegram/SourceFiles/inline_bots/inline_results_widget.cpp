@@ -1000,7 +1000,7 @@ void Widget::inlineBotChanged() {
 	_inlineRequestId = 0;
 	_inlineQuery = _inlineNextQuery = _inlineNextOffset = QString();
 	_inlineBot = nullptr;
-	_inlineCache.clear();
+	_inlineShownEntry = nullptr;
 	_inner->inlineBotChanged();
 	_inner->hideInlineRowsPanel();
 
@@ -1022,6 +1022,7 @@ void Widget::inlineResultsDone(const MTPmessages_BotResults &result) {
 
 		if (it == _inlineCache.cend()) {
 			it = _inlineCache.emplace(_inlineQuery, std::make_unique<internal::CacheEntry>()).first;
+			it->second->expires = ResultsCacheExpires(d.vcache_time.v);
 		}
 		auto entry = it->second.get();
 		entry->nextOffset = qs(d.vnext_offset);
@@ -1052,6 +1053,9 @@ void Widget::inlineResultsDone(const MTPmessages_BotResults &result) {
 	if (!showInlineRows(!adding)) {
 		it->second->nextOffset = QString();
 	}
+	TrimResultsCache(_inlineCache, _inlineShownEntry, [&] {
+		_inner->deleteUnusedInlineLayouts();
+	});
 	onScroll();
 }
 
@@ -1062,6 +1066,15 @@ void Widget::queryInlineBot(UserData *bot, PeerData *peer, QString query) {
 		inlineBotChanged();
 		_inlineBot = bot;
 		force = true;
+
+		// The cache survives hiding the panel for the same bot and chat.
+		// No layouts are left after inlineBotChanged(), so it is safe
+		// to destroy the results of another bot here.
+		if (_inlineCacheBot != bot || _inlineCachePeer != peer) {
+			_inlineCache.clear();
+			_inlineCacheBot = bot;
+			_inlineCachePeer = peer;
+		}
 	}
 
 	if (_inlineQuery != query || force) {
@@ -1070,7 +1083,7 @@ void Widget::queryInlineBot(UserData *bot, PeerData *peer, QString query) {
 			_inlineRequestId = 0;
 			Notify::inlineBotRequesting(false);
 		}
-		if (_inlineCache.find(query) != _inlineCache.cend()) {
+		if (FreshResultsCacheEntry(_inlineCache, query)) {
 			_inlineRequestTimer.stop();
 			_inlineQuery = _inlineNextQuery = query;
 			showInlineRows(true);
@@ -1087,6 +1100,14 @@ void Widget::onInlineRequest() {
 
 	QString nextOffset;
 	auto it = _inlineCache.find(_inlineQuery);
+	if (it != _inlineCache.cend()
+		&& it->second.get() != _inlineShownEntry
+		&& ResultsCacheEntryExpired(*it->second)) {
+		// Request the expired results again from the beginning.
+		_inner->deleteUnusedInlineLayouts();
+		_inlineCache.erase(it);
+		it = _inlineCache.end();
+	}
 	if (it != _inlineCache.cend()) {
 		nextOffset = it->second->nextOffset;
 		if (nextOffset.isEmpty()) {
@@ -1116,7 +1137,9 @@ bool Widget::refreshInlineRows(int *added) {
 			entry = it->second.get();
 		}
 		_inlineNextOffset = it->second->nextOffset;
+		it->second->used = getms(true);
 	}
+	_inlineShownEntry = entry;
 	if (!entry) prepareCache();
 	auto result = _inner->refreshInlineRows(_inlineQueryPeer, _inlineBot, entry, false);
 	if (added) *added = result;
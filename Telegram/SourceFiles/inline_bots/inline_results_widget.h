@@ -12,6 +12,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "ui/effects/panel_animation.h"
 #include "mtproto/sender.h"
 #include "inline_bots/inline_bot_layout_item.h"
+#include "inline_bots/inline_results_cache.h"
 
 namespace Ui {
 class ScrollArea;
@@ -44,6 +45,8 @@ struct CacheEntry {
 	QString nextOffset;
 	QString switchPmText, switchPmStartToken;
 	Results results;
+	TimeMs expires = 0;
+	TimeMs used = 0;
 };
 
 class Inner : public TWidget, public Context, private base::Subscriber {
@@ -58,6 +61,9 @@ public:
 
 	int refreshInlineRows(PeerData *queryPeer, UserData *bot, const CacheEntry *results, bool resultsDeleted);
 	void inlineBotChanged();
+
+	// Must be called before destroying results that are not shown.
+	void deleteUnusedInlineLayouts();
 	void hideInlineRowsPanel();
 	void clearInlineRowsPanel();
 
@@ -138,7 +144,6 @@ private:
 	bool inlineRowFinalize(Row &row, int32 &sumWidth, bool force = false);
 
 	Row &layoutInlineRow(Row &row, int32 sumWidth = 0);
-	void deleteUnusedInlineLayouts();
 
 	int validateExistingInlineRows(const Results &results);
 	void selectInlineResult(int row, int column);
@@ -251,7 +256,10 @@ private:
 	object_ptr<Ui::ScrollArea> _scroll;
 	QPointer<internal::Inner> _inner;
 
-	std::map<QString, std::unique_ptr<internal::CacheEntry>> _inlineCache;
+	ResultsCache<internal::CacheEntry> _inlineCache;
+	UserData *_inlineCacheBot = nullptr;
+	PeerData *_inlineCachePeer = nullptr;
+	const internal::CacheEntry *_inlineShownEntry = nullptr;
 	QTimer _inlineRequestTimer;
 
 	UserData *_inlineBot = nullptr;
@@ -1083,6 +1083,7 @@ void MainWidget::deletedContact(UserData *user, const MTPcontacts_Link &result)
 }
 
 void MainWidget::removeDialog(Dialogs::Key key) {
+	_dialogsBatchCreated.remove(key);
 	_dialogs->removeDialog(key);
 }
 
@@ -1932,9 +1933,28 @@ bool MainWidget::viewsIncrementFail(const RPCError &error, mtpRequestId req) {
 }
 
 void MainWidget::createDialog(Dialogs::Key key) {
+	if (_dialogsBatchLevel > 0) {
+		_dialogsBatchCreated.emplace(key);
+		return;
+	}
 	_dialogs->createDialog(key);
 }
 
+void MainWidget::startDialogsBatch() {
+	++_dialogsBatchLevel;
+}
+
+void MainWidget::finishDialogsBatch() {
+	Expects(_dialogsBatchLevel > 0);
+
+	if (--_dialogsBatchLevel > 0) {
+		return;
+	}
+	for (const auto key : base::take(_dialogsBatchCreated)) {
+		_dialogs->createDialog(key);
+	}
+}
+
 void MainWidget::choosePeer(PeerId peerId, MsgId showAtMsgId) {
 	if (selectingPeer()) {
 		offerPeer(peerId);
@@ -3397,11 +3417,20 @@ void MainWidget::feedChannelDifference(
 	App::feedUsers(data.vusers);
 	App::feedChats(data.vchats);
 
+	const auto started = getms(true);
 	_handlingChannelDifference = true;
+	startDialogsBatch();
 	feedMessageIds(data.vother_updates);
 	App::feedMsgs(data.vnew_messages, NewMessageUnread);
 	feedUpdateVector(data.vother_updates, true);
+	finishDialogsBatch();
 	_handlingChannelDifference = false;
+
+	DEBUG_LOG(("Difference Info: channel difference with %1 messages "
+		"and %2 updates applied in %3 ms."
+		).arg(data.vnew_messages.v.size()
+		).arg(data.vother_updates.v.size()
+		).arg(getms(true) - started));
 }
 
 bool MainWidget::failChannelDifference(ChannelData *channel, const RPCError &error) {
@@ -3548,12 +3577,21 @@ void MainWidget::feedDifference(
 		const MTPVector<MTPChat> &chats,
 		const MTPVector<MTPMessage> &msgs,
 		const MTPVector<MTPUpdate> &other) {
+	const auto started = getms(true);
 	Auth().checkAutoLock();
 	App::feedUsers(users);
 	App::feedChats(chats);
+	startDialogsBatch();
 	feedMessageIds(other);
 	App::feedMsgs(msgs, NewMessageUnread);
 	feedUpdateVector(other, true);
+	finishDialogsBatch();
+
+	DEBUG_LOG(("Difference Info: difference with %1 messages "
+		"and %2 updates applied in %3 ms."
+		).arg(msgs.v.size()
+		).arg(other.v.size()
+		).arg(getms(true) - started));
 }
 
 bool MainWidget::failDifference(const RPCError &error) {
@@ -3689,11 +3727,14 @@ void MainWidget::start(const MTPUser *self) {
 
 	_started = true;
 	App::wnd()->sendServiceHistoryRequest();
+	const auto stickersReadStarted = getms();
 	Local::readInstalledStickers();
 	Local::readFeaturedStickers();
 	Local::readRecentStickers();
 	Local::readFavedStickers();
 	Local::readSavedGifs();
+	DEBUG_LOG(("App Info: stickers and saved gifs read in %1 ms"
+		).arg(getms() - stickersReadStarted));
 	if (const auto availableAt = Local::ReadExportSettings().availableAt) {
 		Auth().data().suggestStartExport(availableAt);
 	}
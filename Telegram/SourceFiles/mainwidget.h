@@ -453,6 +453,8 @@ private:
 	void gotDifference(const MTPupdates_Difference &diff);
 	bool failDifference(const RPCError &e);
 	void feedDifference(const MTPVector<MTPUser> &users, const MTPVector<MTPChat> &chats, const MTPVector<MTPMessage> &msgs, const MTPVector<MTPUpdate> &other);
+	void startDialogsBatch();
+	void finishDialogsBatch();
 	void gotState(const MTPupdates_State &state);
 	void updSetState(int32 pts, int32 date, int32 qts, int32 seq);
 	void gotChannelDifference(ChannelData *channel, const MTPupdates_ChannelDifference &diff);
@@ -603,6 +605,10 @@ private:
 	TimeMs _lastUpdateTime = 0;
 	bool _handlingChannelDifference = false;
 
+	// While a difference is applied chats list rows are moved only once.
+	int _dialogsBatchLevel = 0;
+	base::flat_set<Dialogs::Key> _dialogsBatchCreated;
+
 	QPixmap _cachedBackground;
 	QRect _cachedFor, _willCacheFor;
 	int _cachedX = 0;
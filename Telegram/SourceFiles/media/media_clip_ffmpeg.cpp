@@ -11,6 +11,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "media/media_child_ffmpeg_loader.h"
 #include "storage/file_download.h"
 
+#include <atomic>
+
 namespace Media {
 namespace Clip {
 namespace internal {
@@ -18,6 +20,11 @@ namespace {
 
 constexpr int kSkipInvalidDataPackets = 10;
 constexpr int kAlignImageBy = 16;
+constexpr auto kLoopFramesLimitPerClip = int64(8 * 1024 * 1024);
+constexpr auto kLoopFramesLimitTotal = int64(64 * 1024 * 1024);
+
+// Bytes held by all loop frame caches in all clip threads.
+std::atomic<int64> LoopFramesTotalBytes = { 0 };
 
 void alignedImageBufferCleanupHandler(void *data) {
 	auto buffer = static_cast<uchar*>(data);
@@ -56,6 +63,10 @@ ReaderImplementation::ReadResult FFMpegReaderImplementation::readNextFrame() {
 	if (_frameRead) {
 		av_frame_unref(_frame);
 		_frameRead = false;
+		_loopFrameSkipped = true;
+	}
+	if (_loopCacheState == LoopCacheState::Ready) {
+		return readLoopFrame();
 	}
 
 	do {
@@ -75,23 +86,16 @@ ReaderImplementation::ReadResult FFMpegReaderImplementation::readNextFrame() {
 				return ReadResult::Error;
 			}
 
-			if ((res = avformat_seek_file(_fmtContext, _streamId, std::numeric_limits<int64_t>::min(), 0, std::numeric_limits<int64_t>::max(), 0)) < 0) {
-				if ((res = av_seek_frame(_fmtContext, _streamId, 0, AVSEEK_FLAG_BYTE)) < 0) {
-					if ((res = av_seek_frame(_fmtContext, _streamId, 0, AVSEEK_FLAG_FRAME)) < 0) {
-						if ((res = av_seek_frame(_fmtContext, _streamId, 0, 0)) < 0) {
-							char err[AV_ERROR_MAX_STRING_SIZE] = { 0 };
-							LOG(("Gif Error: Unable to av_seek_frame() to the start %1, error %2, %3").arg(logData()).arg(res).arg(av_make_error_string(err, sizeof(err), res)));
-							return ReadResult::Error;
-						}
-					}
-				}
+			finishLoopFramesCollecting();
+			if (!seekToStart()) {
+				return ReadResult::Error;
+			}
+			if (_loopCacheState == LoopCacheState::Ready) {
+				// The first frame is shown after the last one for its duration.
+				_loopFrames.front().delay = _nextFrameDelay;
+				_loopFrameIndex = -1;
+				return readLoopFrame();
 			}
-			avcodec_flush_buffers(_codecContext);
-			_hadFrame = false;
-			_frameMs = 0;
-			_lastReadVideoMs = _lastReadAudioMs = 0;
-			_skippedInvalidDataPackets = 0;
-
 			continue;
 		} else if (res != AVERROR(EAGAIN)) {
 			char err[AV_ERROR_MAX_STRING_SIZE] = { 0 };
@@ -135,6 +139,129 @@ ReaderImplementation::ReadResult FFMpegReaderImplementation::readNextFrame() {
 	return ReadResult::Error;
 }
 
+bool FFMpegReaderImplementation::seekToStart() {
+	auto res = 0;
+	if ((res = avformat_seek_file(_fmtContext, _streamId, std::numeric_limits<int64_t>::min(), 0, std::numeric_limits<int64_t>::max(), 0)) < 0) {
+		if ((res = av_seek_frame(_fmtContext, _streamId, 0, AVSEEK_FLAG_BYTE)) < 0) {
+			if ((res = av_seek_frame(_fmtContext, _streamId, 0, AVSEEK_FLAG_FRAME)) < 0) {
+				if ((res = av_seek_frame(_fmtContext, _streamId, 0, 0)) < 0) {
+					char err[AV_ERROR_MAX_STRING_SIZE] = { 0 };
+					LOG(("Gif Error: Unable to av_seek_frame() to the start %1, error %2, %3").arg(logData()).arg(res).arg(av_make_error_string(err, sizeof(err), res)));
+					return false;
+				}
+			}
+		}
+	}
+	avcodec_flush_buffers(_codecContext);
+	resetToStartState();
+	return true;
+}
+
+void FFMpegReaderImplementation::resetToStartState() {
+	_hadFrame = false;
+	_frameMs = 0;
+	_lastReadVideoMs = _lastReadAudioMs = 0;
+	_skippedInvalidDataPackets = 0;
+	_loopFramesFromStart = true;
+	_loopFrameSkipped = false;
+}
+
+bool FFMpegReaderImplementation::loopCacheAllowed() const {
+	return (_mode == Mode::Silent)
+		&& (_audioStreamId < 0)
+		&& (_loopCacheState == LoopCacheState::Collecting);
+}
+
+void FFMpegReaderImplementation::storeLoopFrame(
+		const QImage &frame,
+		bool hasAlpha) {
+	if (!loopCacheAllowed() || !_loopFramesFromStart || _loopFrameSkipped) {
+		return;
+	}
+	if (_loopFrames.empty()) {
+		_loopFramesSize = frame.size();
+	} else if (_loopFramesSize != frame.size()) {
+		clearLoopFrames();
+		_loopFramesFromStart = false;
+		return;
+	}
+
+	// Frames are kept in the output format, so replaying doesn't convert.
+	auto stored = LoopFrame();
+	stored.image = frame.copy();
+	stored.alpha = hasAlpha;
+	stored.frameMs = _frameMs;
+	stored.delay = _currentFrameDelay;
+
+	const auto bytes = int64(stored.image.byteCount());
+	const auto total = (LoopFramesTotalBytes += bytes);
+	_loopFramesBytes += bytes;
+	_loopFrames.push_back(std::move(stored));
+	if (_loopFramesBytes > kLoopFramesLimitPerClip) {
+		// This loop will never fit, stop trying.
+		clearLoopFrames();
+		_loopCacheState = LoopCacheState::Disabled;
+	} else if (total > kLoopFramesLimitTotal) {
+		// Try again on the next loop, maybe other clips are gone by then.
+		clearLoopFrames();
+		_loopFramesFromStart = false;
+	}
+}
+
+void FFMpegReaderImplementation::finishLoopFramesCollecting() {
+	if (!loopCacheAllowed()) {
+		return;
+	} else if (_loopFramesFromStart
+		&& !_loopFrameSkipped
+		&& !_loopFrames.empty()) {
+		_loopCacheState = LoopCacheState::Ready;
+	} else {
+		clearLoopFrames();
+	}
+}
+
+void FFMpegReaderImplementation::clearLoopFrames() {
+	LoopFramesTotalBytes -= _loopFramesBytes;
+	_loopFramesBytes = 0;
+	_loopFrames.clear();
+	_loopFrameIndex = 0;
+	if (_loopCacheState == LoopCacheState::Ready) {
+		_loopCacheState = LoopCacheState::Collecting;
+	}
+}
+
+ReaderImplementation::ReadResult FFMpegReaderImplementation::readLoopFrame() {
+	Expects(!_loopFrames.empty());
+
+	if (++_loopFrameIndex >= int(_loopFrames.size())) {
+		_loopFrameIndex = 0;
+	}
+	const auto &frame = _loopFrames[_loopFrameIndex];
+	_frameMs = frame.frameMs;
+	_currentFrameDelay = frame.delay;
+	_hadFrame = _frameRead = true;
+	_frameTime += _currentFrameDelay;
+	return ReadResult::Success;
+}
+
+bool FFMpegReaderImplementation::renderLoopFrame(
+		QImage &to,
+		bool &hasAlpha,
+		const QSize &size) {
+	const auto &frame = _loopFrames[_loopFrameIndex];
+	hasAlpha = frame.alpha;
+	to = frame.image;
+
+	if (!size.isEmpty() && size != _loopFramesSize) {
+		// The requested size has changed, decode again from the start.
+		// The decoder was left at the start when the cache became ready.
+		clearLoopFrames();
+		resetToStartState();
+		to = to.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+	}
+	return true;
+}
+
 void FFMpegReaderImplementation::processReadFrame() {
 	int64 duration = _frame->pkt_duration;
 	int64 framePts = _frame->pts;
@@ -210,6 +337,10 @@ bool FFMpegReaderImplementation::renderFrame(QImage &to, bool &hasAlpha, const Q
 	Expects(_frameRead);
 	_frameRead = false;
 
+	if (_loopCacheState == LoopCacheState::Ready) {
+		return renderLoopFrame(to, hasAlpha, size);
+	}
+
 	if (!_width || !_height) {
 		_width = _frame->width;
 		_height = _frame->height;
@@ -255,6 +386,7 @@ bool FFMpegReaderImplementation::renderFrame(QImage &to, bool &hasAlpha, const Q
 		}
 		to = to.transformed(rotationTransform);
 	}
+	storeLoopFrame(to, hasAlpha);
 
 	// Read some future packets for audio stream.
 	if (_audioStreamId >= 0) {
@@ -406,6 +538,7 @@ bool FFMpegReaderImplementation::start(Mode mode, TimeMs &positionMs) {
 	if (hasAudio()) {
 		Player::mixer()->play(_audioMsgId, std::move(soundData), positionMs);
 	}
+	_loopFramesFromStart = (positionMs <= 0);
 
 	if (readResult == PacketResult::Ok) {
 		processPacket(&packet);
@@ -460,6 +593,7 @@ QString FFMpegReaderImplementation::logData() const {
 
 FFMpegReaderImplementation::~FFMpegReaderImplementation() {
 	clearPacketQueue();
+	clearLoopFrames();
 
 	if (_frameRead) {
 		av_frame_unref(_frame);
@@ -74,6 +74,28 @@ private:
 	void finishPacket();
 	void clearPacketQueue();
 
+	bool seekToStart();
+	void resetToStartState();
+
+	// Short silent loops are decoded once and then replayed from memory.
+	enum class LoopCacheState {
+		Collecting,
+		Ready,
+		Disabled,
+	};
+	struct LoopFrame {
+		QImage image;
+		bool alpha = false;
+		TimeMs frameMs = 0;
+		int delay = 0;
+	};
+	bool loopCacheAllowed() const;
+	void storeLoopFrame(const QImage &frame, bool hasAlpha);
+	void finishLoopFramesCollecting();
+	void clearLoopFrames();
+	ReadResult readLoopFrame();
+	bool renderLoopFrame(QImage &to, bool &hasAlpha, const QSize &size);
+
 	static int _read(void *opaque, uint8_t *buf, int buf_size);
 	static int64_t _seek(void *opaque, int64_t offset, int whence);
 
@@ -117,6 +139,14 @@ private:
 	TimeMs _frameTime = 0;
 	TimeMs _frameTimeCorrection = 0;
 
+	LoopCacheState _loopCacheState = LoopCacheState::Collecting;
+	std::vector<LoopFrame> _loopFrames;
+	QSize _loopFramesSize;
+	int64 _loopFramesBytes = 0;
+	int _loopFrameIndex = 0;
+	bool _loopFramesFromStart = false;
+	bool _loopFrameSkipped = false;
+
 };
 
 } // namespace internal
@@ -28,6 +28,39 @@ namespace {
 QVector<QThread*> threads;
 QVector<Manager*> managers;
 
+// Copies an already scaled ARGB32 frame into the premultiplied cache,
+// blending it over the transparent image background if it has alpha.
+void CopyFrameToCache(const QImage &original, bool hasAlpha, QImage &cache, QPoint position) {
+	const auto width = original.width();
+	const auto height = original.height();
+	const auto fromPerLine = original.bytesPerLine() / sizeof(uint32);
+	const auto toPerLine = cache.bytesPerLine() / sizeof(uint32);
+	auto from = reinterpret_cast<const uint32*>(original.constBits());
+	auto to = reinterpret_cast<uint32*>(cache.bits())
+		+ position.y() * toPerLine
+		+ position.x();
+	if (!hasAlpha) {
+		for (auto y = 0; y != height; ++y) {
+			memcpy(to, from, width * sizeof(uint32));
+			from += fromPerLine;
+			to += toPerLine;
+		}
+		return;
+	}
+	const auto bg = anim::shifted(st::imageBgTransparent->c);
+	for (auto y = 0; y != height; ++y) {
+		for (auto x = 0; x != width; ++x) {
+			const auto pixel = from[x];
+			const auto a = (pixel >> 24);
+			const auto alpha = a + (a >> 7);
+			const auto components = anim::shifted(pixel | 0xFF000000U);
+			to[x] = anim::unshifted(components * alpha + bg * (256 - alpha));
+		}
+		from += fromPerLine;
+		to += toPerLine;
+	}
+}
+
 QImage PrepareFrameImage(const FrameRequest &request, const QImage &original, bool hasAlpha, QImage &cache) {
 	auto needResize = (original.width() != request.framew) || (original.height() != request.frameh);
 	auto needOuterFill = (request.outerw != request.framew) || (request.outerh != request.frameh);
@@ -42,7 +75,20 @@ QImage PrepareFrameImage(const FrameRequest &request, const QImage &original, bo
 		cache = QImage(request.outerw, request.outerh, QImage::Format_ARGB32_Premultiplied);
 		cache.setDevicePixelRatio(factor);
 	}
-	{
+	auto position = QPoint((request.outerw - request.framew) / (2 * factor), (request.outerh - request.frameh) / (2 * factor));
+	auto fused = !needResize
+		&& (original.format() == QImage::Format_ARGB32)
+		&& (position.x() >= 0)
+		&& (position.y() >= 0)
+		&& (position.x() * factor + original.width() <= cache.width())
+		&& (position.y() * factor + original.height() <= cache.height());
+	if (fused) {
+		// Single pass instead of filling and painting with QPainter.
+		if (needNewCache && needOuterFill) {
+			cache.fill(st::imageBg->c);
+		}
+		CopyFrameToCache(original, hasAlpha, cache, position * factor);
+	} else {
 		Painter p(&cache);
 		if (needNewCache) {
 			if (request.framew < request.outerw) {
@@ -57,7 +103,6 @@ QImage PrepareFrameImage(const FrameRequest &request, const QImage &original, bo
 		if (hasAlpha) {
 			p.fillRect(qMax(0, (request.outerw - request.framew) / (2 * factor)), qMax(0, (request.outerh - request.frameh) / (2 * factor)), qMin(cache.width(), request.framew) / factor, qMin(cache.height(), request.frameh) / factor, st::imageBgTransparent);
 		}
-		auto position = QPoint((request.outerw - request.framew) / (2 * factor), (request.outerh - request.frameh) / (2 * factor));
 		if (needResize) {
 			PainterHighQualityEnabler hq(p);
 
@@ -40,12 +40,20 @@ namespace {
 
 constexpr auto kPreloadCount = 4;
 
+// Preload further ahead when the user is flipping through quickly.
+constexpr auto kPreloadCountFast = 8;
+constexpr auto kFastNavigationTimeout = TimeMs(500);
+
 // Preload X message ids before and after current.
 constexpr auto kIdsLimit = 48;
 
 // Preload next messages if we went further from current than that.
 constexpr auto kIdsPreloadAfter = 28;
 
+// Prepare halved copies for images larger than that.
+constexpr auto kCurrentLevelsMinPixels = 4096 * 4096;
+constexpr auto kCurrentLevelsMinSide = 1024;
+
 } // namespace
 
 struct MediaView::SharedMedia {
@@ -689,6 +697,7 @@ void MediaView::clearData() {
 	_doc = nullptr;
 	_fullScreenVideo = false;
 	_caption.clear();
+	_preloadingPhotos.clear();
 }
 
 MediaView::~MediaView() {
@@ -1350,6 +1359,7 @@ void MediaView::showPhoto(not_null<PhotoData*> photo, HistoryItem *context) {
 	refreshMediaViewer();
 
 	displayPhoto(photo, context);
+	_preloadDirection = 0;
 	preloadData(0);
 	activateControls();
 }
@@ -1373,6 +1383,7 @@ void MediaView::showPhoto(not_null<PhotoData*> photo, not_null<PeerData*> contex
 	refreshMediaViewer();
 
 	displayPhoto(photo, 0);
+	_preloadDirection = 0;
 	preloadData(0);
 	activateControls();
 }
@@ -1401,6 +1412,7 @@ void MediaView::showDocument(not_null<DocumentData*> document, HistoryItem *cont
 		_autoplayVideoDocument = document;
 	}
 	displayDocument(document, context);
+	_preloadDirection = 0;
 	preloadData(0);
 	activateControls();
 }
@@ -1425,6 +1437,7 @@ void MediaView::displayPhoto(not_null<PhotoData*> photo, HistoryItem *item) {
 	Auth().downloader().clearPriorities();
 	_full = -1;
 	_current = QPixmap();
+	clearCurrentLevels();
 	_down = OverNone;
 	_w = convertScale(photo->full->width());
 	_h = convertScale(photo->full->height());
@@ -1461,6 +1474,7 @@ void MediaView::destroyThemePreview() {
 
 void MediaView::displayDocument(DocumentData *doc, HistoryItem *item) { // empty messages shown as docs: doc can be NULL
 	auto documentChanged = (!doc || doc != _doc || (item && item->fullId() != _msgid));
+	clearCurrentLevels();
 	if (documentChanged || (!doc->isAnimation() && !doc->isVideoFile())) {
 		_fullScreenVideo = false;
 		_current = QPixmap();
@@ -1503,7 +1517,9 @@ void MediaView::displayDocument(DocumentData *doc, HistoryItem *item) { // empty
 				auto &location = _doc->location(true);
 				if (location.accessEnable()) {
 					if (QImageReader(location.name()).canRead()) {
-						_current = App::pixmapFromImageInPlace(App::readImage(location.name(), 0, false));
+						auto image = App::readImage(location.name(), 0, false);
+						prepareCurrentLevels(image);
+						_current = App::pixmapFromImageInPlace(std::move(image));
 					}
 				}
 				location.accessDisable();
@@ -1973,7 +1989,7 @@ void MediaView::paintEvent(QPaintEvent *e) {
 		QRect imgRect(_x, _y, _w, _h);
 		if (imgRect.intersects(r)) {
 			auto rounding = (_doc && _doc->isVideoMessage()) ? ImageRoundRadius::Ellipse : ImageRoundRadius::None;
-			auto toDraw = _current.isNull() ? _gif->current(_gif->width() / cIntRetinaFactor(), _gif->height() / cIntRetinaFactor(), _gif->width() / cIntRetinaFactor(), _gif->height() / cIntRetinaFactor(), rounding, RectPart::AllCorners, ms) : _current;
+			auto toDraw = _current.isNull() ? _gif->current(_gif->width() / cIntRetinaFactor(), _gif->height() / cIntRetinaFactor(), _gif->width() / cIntRetinaFactor(), _gif->height() / cIntRetinaFactor(), rounding, RectPart::AllCorners, ms) : currentForWidth(_w * cIntRetinaFactor());
 			if (!_gif && (!_doc || !_doc->sticker() || _doc->sticker()->img->isNull()) && toDraw.hasAlpha()) {
 				p.fillRect(imgRect, _transparentBrush);
 			}
@@ -2401,6 +2417,56 @@ void MediaView::wheelEvent(QWheelEvent *e) {
 	}
 }
 
+void MediaView::prepareCurrentLevels(QImage image) {
+	if (image.width() * image.height() < kCurrentLevelsMinPixels) {
+		return;
+	}
+	const auto requestId = ++_currentLevelsRequestId;
+	crl::async([=, image = std::move(image)]() mutable {
+		auto levels = std::vector<QImage>();
+		auto level = std::move(image);
+		while (std::max(level.width(), level.height()) > kCurrentLevelsMinSide
+			&& level.width() > 1
+			&& level.height() > 1) {
+			level = level.scaled(
+				level.width() / 2,
+				level.height() / 2,
+				Qt::IgnoreAspectRatio,
+				Qt::SmoothTransformation);
+			levels.push_back(level);
+		}
+		crl::on_main(this, [=, levels = std::move(levels)]() mutable {
+			if (requestId != _currentLevelsRequestId) {
+				return;
+			}
+			for (auto &level : levels) {
+				_currentLevels.push_back(
+					App::pixmapFromImageInPlace(std::move(level)));
+				_currentLevels.back().setDevicePixelRatio(
+					_current.devicePixelRatio());
+			}
+			update();
+		});
+	});
+}
+
+void MediaView::clearCurrentLevels() {
+	_currentLevels.clear();
+	++_currentLevelsRequestId;
+}
+
+QPixmap MediaView::currentForWidth(int width) const {
+	// The smallest level that is still not smaller than required.
+	auto result = _current;
+	for (const auto &level : _currentLevels) {
+		if (level.width() < width) {
+			break;
+		}
+		result = level;
+	}
+	return result;
+}
+
 void MediaView::setZoomLevel(int newZoom) {
 	if (_zoom == newZoom) return;
 
@@ -2541,19 +2607,39 @@ bool MediaView::moveToEntity(const Entity &entity, int preloadDelta) {
 	} else {
 		displayDocument(nullptr, entity.item);
 	}
+	if (preloadDelta) {
+		countPreloadHit();
+	}
 	preloadData(preloadDelta);
 	return true;
 }
 
+void MediaView::countPreloadHit() {
+	const auto hit = _photo
+		? _photo->loaded()
+		: (_doc && _doc->loaded());
+	++_preloadShown;
+	if (hit) {
+		++_preloadHits;
+	}
+	DEBUG_LOG(("MediaView Info: preload hits %1 of %2."
+		).arg(_preloadHits
+		).arg(_preloadShown));
+}
+
 void MediaView::preloadData(int delta) {
 	if (!_index) {
 		return;
 	}
-	auto from = *_index + (delta ? delta : -1);
-	auto till = *_index + (delta ? delta * kPreloadCount : 1);
-	if (from > till) std::swap(from, till);
-
 	if (delta != 0) {
+		const auto direction = (delta > 0) ? 1 : -1;
+		const auto now = getms();
+		const auto fast = (direction == _preloadDirection)
+			&& (now - _lastNavigationTime < kFastNavigationTimeout);
+		_preloadDirection = direction;
+		_preloadCount = fast ? kPreloadCountFast : kPreloadCount;
+		_lastNavigationTime = now;
+
 		auto forgetIndex = *_index - delta * 2;
 		auto entity = entityByIndex(forgetIndex);
 		if (auto photo = base::get_if<not_null<PhotoData*>>(&entity.data)) {
@@ -2561,11 +2647,31 @@ void MediaView::preloadData(int delta) {
 		} else if (auto document = base::get_if<not_null<DocumentData*>>(&entity.data)) {
 			(*document)->forget();
 		}
+	} else if (!_preloadDirection) {
+		_preloadCount = kPreloadCount;
 	}
 
-	for (auto index = from; index != till; ++index) {
+	// Items ahead in the direction of navigation and one behind,
+	// or one on each side if we didn't move yet.
+	auto indices = std::vector<int>();
+	if (_preloadDirection) {
+		indices.push_back(*_index - _preloadDirection);
+		for (auto i = 1; i != _preloadCount; ++i) {
+			indices.push_back(*_index + i * _preloadDirection);
+		}
+	} else {
+		indices.push_back(*_index - 1);
+		indices.push_back(*_index + 1);
+	}
+
+	auto preloading = base::flat_set<not_null<PhotoData*>>();
+	for (const auto index : indices) {
 		auto entity = entityByIndex(index);
 		if (auto photo = base::get_if<not_null<PhotoData*>>(&entity.data)) {
+			if (_preloadingPhotos.contains(*photo)
+				|| (!(*photo)->loaded() && !(*photo)->loading())) {
+				preloading.emplace(*photo);
+			}
 			(*photo)->download();
 		} else if (auto document = base::get_if<not_null<DocumentData*>>(&entity.data)) {
 			if (auto sticker = (*document)->sticker()) {
@@ -2576,6 +2682,16 @@ void MediaView::preloadData(int delta) {
 			}
 		}
 	}
+
+	// Photos we started loading that the user has already passed.
+	for (const auto photo : _preloadingPhotos) {
+		if (!preloading.contains(photo)
+			&& photo != _photo
+			&& photo->loading()) {
+			photo->stopLoading();
+		}
+	}
+	_preloadingPhotos = std::move(preloading);
 }
 
 void MediaView::mousePressEvent(QMouseEvent *e) {
@@ -139,6 +139,7 @@ private:
 	void moveToScreen();
 	bool moveToNext(int delta);
 	void preloadData(int delta);
+	void countPreloadHit();
 	struct Entity {
 		base::optional_variant<
 			not_null<PhotoData*>,
@@ -205,6 +206,10 @@ private:
 
 	void initAnimation();
 	void createClipReader();
+
+	void prepareCurrentLevels(QImage image);
+	void clearCurrentLevels();
+	QPixmap currentForWidth(int width) const;
 	Images::Options videoThumbOptions() const;
 
 	void initThemePreview();
@@ -287,9 +292,23 @@ private:
 	bool _pressed = false;
 	int32 _dragging = 0;
 	QPixmap _current;
+
+	// Halved copies of a huge image, so that zoomed out views are
+	// painted from a pixmap close to the displayed size.
+	std::vector<QPixmap> _currentLevels;
+	int _currentLevelsRequestId = 0;
+
 	Media::Clip::ReaderPointer _gif;
 	int32 _full = -1; // -1 - thumb, 0 - medium, 1 - full
 
+	// Preload state, the direction is zero until the user navigates.
+	int _preloadDirection = 0;
+	int _preloadCount = 0;
+	TimeMs _lastNavigationTime = 0;
+	base::flat_set<not_null<PhotoData*>> _preloadingPhotos;
+	int _preloadShown = 0;
+	int _preloadHits = 0;
+
 	// Video without audio stream playback information.
 	bool _videoIsSilent = false;
 	bool _videoPaused = false;
@@ -0,0 +1,319 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "mtproto/aes_ni.h"
+
+#include "base/assertion.h"
+#include "base/build_config.h"
+
+#include <cstring>
+
+#ifdef ARCH_CPU_X86_FAMILY
+#define MTP_AES_NI
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#ifdef COMPILER_MSVC
+#include <intrin.h>
+#else // COMPILER_MSVC
+#include <cpuid.h>
+#endif // COMPILER_MSVC
+#endif // ARCH_CPU_X86_FAMILY
+
+// GCC and Clang allow AES-NI intrinsics only in functions built for it.
+#if defined MTP_AES_NI && !defined COMPILER_MSVC
+#define AES_NI_TARGET __attribute__((target("aes,sse2")))
+#else // MTP_AES_NI && !COMPILER_MSVC
+#define AES_NI_TARGET
+#endif // MTP_AES_NI && !COMPILER_MSVC
+
+namespace MTP {
+namespace internal {
+namespace AesNi {
+
+#ifdef MTP_AES_NI
+
+namespace {
+
+constexpr auto kRounds = 14;
+constexpr auto kBlockSize = 16;
+
+// Blocks encrypted at once in CTR mode, enough to fill the AES pipeline.
+constexpr auto kCtrParallel = 4;
+
+struct Schedule {
+	__m128i keys[kRounds + 1];
+};
+
+bool DetectSupport() {
+#ifdef COMPILER_MSVC
+	int info[4] = { 0 };
+	__cpuid(info, 1);
+	const auto ecx = unsigned(info[2]);
+	const auto edx = unsigned(info[3]);
+#else // COMPILER_MSVC
+	auto eax = 0U, ebx = 0U, ecx = 0U, edx = 0U;
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+		return false;
+	}
+#endif // COMPILER_MSVC
+	const auto sse2 = (edx & (1U << 26)) != 0;
+	const auto aes = (ecx & (1U << 25)) != 0;
+	return sse2 && aes;
+}
+
+AES_NI_TARGET inline __m128i ExpandFirst(__m128i key, __m128i assist) {
+	assist = _mm_shuffle_epi32(assist, 0xFF);
+	auto shifted = _mm_slli_si128(key, 4);
+	key = _mm_xor_si128(key, shifted);
+	shifted = _mm_slli_si128(shifted, 4);
+	key = _mm_xor_si128(key, shifted);
+	shifted = _mm_slli_si128(shifted, 4);
+	key = _mm_xor_si128(key, shifted);
+	return _mm_xor_si128(key, assist);
+}
+
+AES_NI_TARGET inline __m128i ExpandSecond(__m128i previous, __m128i key) {
+	const auto assist = _mm_shuffle_epi32(
+		_mm_aeskeygenassist_si128(previous, 0x00),
+		0xAA);
+	auto shifted = _mm_slli_si128(key, 4);
+	key = _mm_xor_si128(key, shifted);
+	shifted = _mm_slli_si128(shifted, 4);
+	key = _mm_xor_si128(key, shifted);
+	shifted = _mm_slli_si128(shifted, 4);
+	key = _mm_xor_si128(key, shifted);
+	return _mm_xor_si128(key, assist);
+}
+
+// The round constant must be an immediate, so each step is unrolled.
+#define AES_NI_EXPAND_256(index, rcon) \
+	first = ExpandFirst(first, _mm_aeskeygenassist_si128(second, rcon)); \
+	result.keys[index] = first; \
+	second = ExpandSecond(first, second); \
+	result.keys[index + 1] = second;
+
+AES_NI_TARGET Schedule PrepareEncryptKeys(const uchar *key) {
+	auto result = Schedule();
+	auto first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key));
+	auto second = _mm_loadu_si128(
+		reinterpret_cast<const __m128i*>(key + kBlockSize));
+	result.keys[0] = first;
+	result.keys[1] = second;
+	AES_NI_EXPAND_256(2, 0x01);
+	AES_NI_EXPAND_256(4, 0x02);
+	AES_NI_EXPAND_256(6, 0x04);
+	AES_NI_EXPAND_256(8, 0x08);
+	AES_NI_EXPAND_256(10, 0x10);
+	AES_NI_EXPAND_256(12, 0x20);
+	first = ExpandFirst(first, _mm_aeskeygenassist_si128(second, 0x40));
+	result.keys[14] = first;
+	return result;
+}
+
+#undef AES_NI_EXPAND_256
+
+AES_NI_TARGET Schedule PrepareDecryptKeys(const uchar *key) {
+	const auto encrypt = PrepareEncryptKeys(key);
+	auto result = Schedule();
+	result.keys[0] = encrypt.keys[kRounds];
+	for (auto i = 1; i != kRounds; ++i) {
+		result.keys[i] = _mm_aesimc_si128(encrypt.keys[kRounds - i]);
+	}
+	result.keys[kRounds] = encrypt.keys[0];
+	return result;
+}
+
+AES_NI_TARGET inline __m128i EncryptBlock(
+		const Schedule &schedule,
+		__m128i block) {
+	block = _mm_xor_si128(block, schedule.keys[0]);
+	for (auto i = 1; i != kRounds; ++i) {
+		block = _mm_aesenc_si128(block, schedule.keys[i]);
+	}
+	return _mm_aesenclast_si128(block, schedule.keys[kRounds]);
+}
+
+AES_NI_TARGET inline __m128i DecryptBlock(
+		const Schedule &schedule,
+		__m128i block) {
+	block = _mm_xor_si128(block, schedule.keys[0]);
+	for (auto i = 1; i != kRounds; ++i) {
+		block = _mm_aesdec_si128(block, schedule.keys[i]);
+	}
+	return _mm_aesdeclast_si128(block, schedule.keys[kRounds]);
+}
+
+AES_NI_TARGET inline __m128i Load(const uchar *data) {
+	return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+}
+
+AES_NI_TARGET inline void Store(uchar *data, __m128i value) {
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(data), value);
+}
+
+// Big endian increment of the whole 128 bit counter, like OpenSSL does.
+inline void IncrementCounter(uchar *counter) {
+	for (auto i = kBlockSize; i != 0;) {
+		if (++counter[--i] != 0) {
+			break;
+		}
+	}
+}
+
+} // namespace
+
+bool Supported() {
+	static const auto result = DetectSupport();
+	return result;
+}
+
+AES_NI_TARGET void IgeEncrypt(
+		const uchar *src,
+		uchar *dst,
+		size_t len,
+		const uchar *key,
+		const uchar *iv) {
+	Expects(len % kBlockSize == 0);
+
+	const auto schedule = PrepareEncryptKeys(key);
+	auto previousOut = Load(iv);
+	auto previousIn = Load(iv + kBlockSize);
+	for (auto till = src + len; src != till; src += kBlockSize, dst += kBlockSize) {
+		const auto in = Load(src);
+		const auto out = _mm_xor_si128(
+			EncryptBlock(schedule, _mm_xor_si128(in, previousOut)),
+			previousIn);
+		Store(dst, out);
+		previousOut = out;
+		previousIn = in;
+	}
+}
+
+AES_NI_TARGET void IgeDecrypt(
+		const uchar *src,
+		uchar *dst,
+		size_t len,
+		const uchar *key,
+		const uchar *iv) {
+	Expects(len % kBlockSize == 0);
+
+	// Each block depends on the previous plain text, so IGE decryption
+	// can't be pipelined, but the hardware rounds are still much faster.
+	const auto schedule = PrepareDecryptKeys(key);
+	auto previousIn = Load(iv);
+	auto previousOut = Load(iv + kBlockSize);
+	for (auto till = src + len; src != till; src += kBlockSize, dst += kBlockSize) {
+		const auto in = Load(src);
+		const auto out = _mm_xor_si128(
+			DecryptBlock(schedule, _mm_xor_si128(in, previousOut)),
+			previousIn);
+		Store(dst, out);
+		previousIn = in;
+		previousOut = out;
+	}
+}
+
+AES_NI_TARGET void CtrEncrypt(
+		uchar *data,
+		size_t len,
+		const uchar *key,
+		uchar *ivec,
+		uchar *ecount,
+		unsigned int *num) {
+	auto n = *num;
+	while (n != 0 && len != 0) {
+		*data++ ^= ecount[n];
+		n = (n + 1) % kBlockSize;
+		--len;
+	}
+
+	const auto schedule = PrepareEncryptKeys(key);
+	uchar counters[kCtrParallel][kBlockSize];
+	while (len >= kCtrParallel * kBlockSize) {
+		__m128i blocks[kCtrParallel];
+		for (auto i = 0; i != kCtrParallel; ++i) {
+			memcpy(counters[i], ivec, kBlockSize);
+			IncrementCounter(ivec);
+			blocks[i] = _mm_xor_si128(Load(counters[i]), schedule.keys[0]);
+		}
+		for (auto round = 1; round != kRounds; ++round) {
+			const auto roundKey = schedule.keys[round];
+			for (auto i = 0; i != kCtrParallel; ++i) {
+				blocks[i] = _mm_aesenc_si128(blocks[i], roundKey);
+			}
+		}
+		for (auto i = 0; i != kCtrParallel; ++i) {
+			const auto stream = _mm_aesenclast_si128(
+				blocks[i],
+				schedule.keys[kRounds]);
+			const auto where = data + i * kBlockSize;
+			Store(where, _mm_xor_si128(Load(where), stream));
+			if (i + 1 == kCtrParallel) {
+				Store(ecount, stream);
+			}
+		}
+		data += kCtrParallel * kBlockSize;
+		len -= kCtrParallel * kBlockSize;
+	}
+	while (len >= kBlockSize) {
+		const auto stream = EncryptBlock(schedule, Load(ivec));
+		IncrementCounter(ivec);
+		Store(ecount, stream);
+		Store(data, _mm_xor_si128(Load(data), stream));
+		data += kBlockSize;
+		len -= kBlockSize;
+	}
+	if (len != 0) {
+		Store(ecount, EncryptBlock(schedule, Load(ivec)));
+		IncrementCounter(ivec);
+		while (len--) {
+			data[n] ^= ecount[n];
+			++n;
+		}
+	}
+	*num = n;
+}
+
+#else // MTP_AES_NI
+
+bool Supported() {
+	return false;
+}
+
+void IgeEncrypt(
+		const uchar *src,
+		uchar *dst,
+		size_t len,
+		const uchar *key,
+		const uchar *iv) {
+	Unexpected("AesNi::IgeEncrypt call without AES-NI support.");
+}
+
+void IgeDecrypt(
+		const uchar *src,
+		uchar *dst,
+		size_t len,
+		const uchar *key,
+		const uchar *iv) {
+	Unexpected("AesNi::IgeDecrypt call without AES-NI support.");
+}
+
+void CtrEncrypt(
+		uchar *data,
+		size_t len,
+		const uchar *key,
+		uchar *ivec,
+		uchar *ecount,
+		unsigned int *num) {
+	Unexpected("AesNi::CtrEncrypt call without AES-NI support.");
+}
+
+#endif // MTP_AES_NI
+
+} // namespace AesNi
+} // namespace internal
+} // namespace MTP
@@ -0,0 +1,48 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include <cstddef>
+#include <QtCore/QtGlobal>
+
+namespace MTP {
+namespace internal {
+namespace AesNi {
+
+// Hardware AES-256 using the AES-NI instructions.
+// Call only if Supported() returned true, otherwise the process crashes.
+bool Supported();
+
+// Same semantics as OpenSSL AES_ige_encrypt with a 32 byte iv,
+// len must be a multiple of 16, src and dst may be the same buffer.
+void IgeEncrypt(
+	const uchar *src,
+	uchar *dst,
+	size_t len,
+	const uchar *key,
+	const uchar *iv);
+void IgeDecrypt(
+	const uchar *src,
+	uchar *dst,
+	size_t len,
+	const uchar *key,
+	const uchar *iv);
+
+// Same semantics as OpenSSL CRYPTO_ctr128_encrypt with AES_encrypt,
+// including the ivec, ecount and num state left after the call.
+void CtrEncrypt(
+	uchar *data,
+	size_t len,
+	const uchar *key,
+	uchar *ivec,
+	uchar *ecount,
+	unsigned int *num);
+
+} // namespace AesNi
+} // namespace internal
+} // namespace MTP
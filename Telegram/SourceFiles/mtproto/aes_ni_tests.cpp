@@ -0,0 +1,199 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "catch.hpp"
+
+#include "mtproto/aes_ni.h"
+
+#include <vector>
+
+namespace AesNi = MTP::internal::AesNi;
+
+namespace {
+
+std::vector<uchar> FromHex(const char *hex) {
+	const auto value = [](char ch) {
+		return (ch >= 'a') ? (ch - 'a' + 10) : (ch - '0');
+	};
+	auto result = std::vector<uchar>();
+	for (; hex[0] && hex[1]; hex += 2) {
+		result.push_back(uchar((value(hex[0]) << 4) | value(hex[1])));
+	}
+	return result;
+}
+
+std::vector<uchar> Sequence(int from, int till) {
+	auto result = std::vector<uchar>();
+	for (auto i = from; i != till; ++i) {
+		result.push_back(uchar(i));
+	}
+	return result;
+}
+
+// FIPS-197, Appendix C.3.
+const auto kBlockKey = Sequence(0x00, 0x20);
+const auto kBlockPlain = FromHex("00112233445566778899aabbccddeeff");
+const auto kBlockCipher = FromHex("8ea2b7ca516745bfeafc49904b496089");
+
+// Computed with OpenSSL AES_ige_encrypt.
+const auto kIgeKey = Sequence(0x00, 0x20);
+const auto kIgeIv = Sequence(0x20, 0x40);
+const auto kIgePlain = Sequence(0x40, 0x80);
+const auto kIgeCipher = FromHex(
+	"b6b23cb46d2f43de2c67fc9a3a9e3510"
+	"4fad6ed15177969c1cebc616bcfa482c"
+	"b220e4d159bedfd570df191a805e9d9d"
+	"13b6d62f0ea1e40541bd31ebe72f51c6");
+
+// NIST SP 800-38A, F.5.5 CTR-AES256.Encrypt.
+const auto kCtrKey = FromHex(
+	"603deb1015ca71be2b73aef0857d7781"
+	"1f352c073b6108d72d9810a30914dff4");
+const auto kCtrCounter = FromHex("f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff");
+const auto kCtrCounterAfter = FromHex("f0f1f2f3f4f5f6f7f8f9fafbfcfdff03");
+const auto kCtrPlain = FromHex(
+	"6bc1bee22e409f96e93d7e117393172a"
+	"ae2d8a571e03ac9c9eb76fac45af8e51"
+	"30c81c46a35ce411e5fbc1191a0a52ef"
+	"f69f2445df4f9b17ad2b417be66c3710");
+const auto kCtrCipher = FromHex(
+	"601ec313775789a5b7a7f504bbf3d228"
+	"f443e3ca4d62b59aca84e990cacaf5c5"
+	"2b0930daa23de94ce87017ba2d84988d"
+	"dfc9c58db67aada613c2dd08457941a6");
+
+struct CtrState {
+	std::vector<uchar> ivec = kCtrCounter;
+	std::vector<uchar> ecount = std::vector<uchar>(16);
+	unsigned int num = 0;
+};
+
+std::vector<uchar> Keystream(int block) {
+	auto result = std::vector<uchar>();
+	for (auto i = block * 16; i != (block + 1) * 16; ++i) {
+		result.push_back(kCtrPlain[i] ^ kCtrCipher[i]);
+	}
+	return result;
+}
+
+} // namespace
+
+TEST_CASE("AES-NI results match the test vectors", "[aes_ni]") {
+	if (!AesNi::Supported()) {
+		WARN("AES-NI is not supported, skipping.");
+		return;
+	}
+
+	SECTION("single block encryption") {
+		// IGE with a zero iv is plain AES on the first block.
+		const auto iv = std::vector<uchar>(32);
+		auto result = std::vector<uchar>(16);
+		AesNi::IgeEncrypt(
+			kBlockPlain.data(),
+			result.data(),
+			16,
+			kBlockKey.data(),
+			iv.data());
+		REQUIRE(result == kBlockCipher);
+
+		AesNi::IgeDecrypt(
+			kBlockCipher.data(),
+			result.data(),
+			16,
+			kBlockKey.data(),
+			iv.data());
+		REQUIRE(result == kBlockPlain);
+	}
+
+	SECTION("ige encryption") {
+		auto result = std::vector<uchar>(kIgePlain.size());
+		AesNi::IgeEncrypt(
+			kIgePlain.data(),
+			result.data(),
+			result.size(),
+			kIgeKey.data(),
+			kIgeIv.data());
+		REQUIRE(result == kIgeCipher);
+	}
+
+	SECTION("ige decryption") {
+		auto result = std::vector<uchar>(kIgeCipher.size());
+		AesNi::IgeDecrypt(
+			kIgeCipher.data(),
+			result.data(),
+			result.size(),
+			kIgeKey.data(),
+			kIgeIv.data());
+		REQUIRE(result == kIgePlain);
+	}
+
+	SECTION("ige in place") {
+		auto data = kIgePlain;
+		AesNi::IgeEncrypt(
+			data.data(),
+			data.data(),
+			data.size(),
+			kIgeKey.data(),
+			kIgeIv.data());
+		REQUIRE(data == kIgeCipher);
+
+		AesNi::IgeDecrypt(
+			data.data(),
+			data.data(),
+			data.size(),
+			kIgeKey.data(),
+			kIgeIv.data());
+		REQUIRE(data == kIgePlain);
+	}
+
+	SECTION("ctr in one call") {
+		auto data = kCtrPlain;
+		auto state = CtrState();
+		AesNi::CtrEncrypt(
+			data.data(),
+			data.size(),
+			kCtrKey.data(),
+			state.ivec.data(),
+			state.ecount.data(),
+			&state.num);
+		REQUIRE(data == kCtrCipher);
+		REQUIRE(state.ivec == kCtrCounterAfter);
+		REQUIRE(state.ecount == Keystream(3));
+		REQUIRE(state.num == 0);
+	}
+
+	SECTION("ctr in chunks carries the state") {
+		auto data = kCtrPlain;
+		auto state = CtrState();
+		const auto encrypt = [&](int offset, int size) {
+			AesNi::CtrEncrypt(
+				data.data() + offset,
+				size,
+				kCtrKey.data(),
+				state.ivec.data(),
+				state.ecount.data(),
+				&state.num);
+		};
+
+		encrypt(0, 5);
+		REQUIRE(state.num == 5);
+		REQUIRE(state.ecount == Keystream(0));
+
+		encrypt(5, 11);
+		REQUIRE(state.num == 0);
+		REQUIRE(state.ecount == Keystream(0));
+
+		encrypt(16, 37);
+		REQUIRE(state.num == 5);
+		REQUIRE(state.ecount == Keystream(3));
+
+		encrypt(53, 11);
+		REQUIRE(state.num == 0);
+		REQUIRE(state.ivec == kCtrCounterAfter);
+		REQUIRE(data == kCtrCipher);
+	}
+}
@@ -7,6 +7,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 */
 #include "mtproto/auth_key.h"
 
+#include "mtproto/aes_ni.h"
+
 extern "C" {
 #include <openssl/aes.h>
 #include <openssl/modes.h>
@@ -72,7 +74,9 @@ void AuthKey::prepareAES(const MTPint128 &msgKey, MTPint256 &aesKey, MTPint256 &
 	memcpy(iv + 8 + 16, sha256_b + 24, 8);
 }
 
-void aesIgeEncryptRaw(const void *src, void *dst, uint32 len, const void *key, const void *iv) {
+namespace {
+
+void OpenSSLIgeEncrypt(const void *src, void *dst, uint32 len, const void *key, const void *iv) {
 	uchar aes_key[32], aes_iv[32];
 	memcpy(aes_key, key, 32);
 	memcpy(aes_iv, iv, 32);
@@ -82,7 +86,7 @@ void aesIgeEncryptRaw(const void *src, void *dst, uint32 len, const void *key, c
 	AES_ige_encrypt(static_cast<const uchar*>(src), static_cast<uchar*>(dst), len, &aes, aes_iv, AES_ENCRYPT);
 }
 
-void aesIgeDecryptRaw(const void *src, void *dst, uint32 len, const void *key, const void *iv) {
+void OpenSSLIgeDecrypt(const void *src, void *dst, uint32 len, const void *key, const void *iv) {
 	uchar aes_key[32], aes_iv[32];
 	memcpy(aes_key, key, 32);
 	memcpy(aes_iv, iv, 32);
@@ -92,7 +96,7 @@ void aesIgeDecryptRaw(const void *src, void *dst, uint32 len, const void *key, c
 	AES_ige_encrypt(static_cast<const uchar*>(src), static_cast<uchar*>(dst), len, &aes, aes_iv, AES_DECRYPT);
 }
 
-void aesCtrEncrypt(bytes::span data, const void *key, CTRState *state) {
+void OpenSSLCtrEncrypt(bytes::span data, const void *key, CTRState *state) {
 	AES_KEY aes;
 	AES_set_encrypt_key(static_cast<const uchar*>(key), 256, &aes);
 
@@ -110,4 +114,106 @@ void aesCtrEncrypt(bytes::span data, const void *key, CTRState *state) {
 		(block128_f)AES_encrypt);
 }
 
+void AesNiCtrEncrypt(bytes::span data, const void *key, CTRState *state) {
+	internal::AesNi::CtrEncrypt(
+		reinterpret_cast<uchar*>(data.data()),
+		data.size(),
+		static_cast<const uchar*>(key),
+		state->ivec,
+		state->ecount,
+		&state->num);
+}
+
+// Compare the hardware implementation with OpenSSL on a fixed input
+// before trusting it with the real traffic and the local storage.
+bool CheckAesNi() {
+	constexpr auto kSize = 16 * 21;
+	uchar key[32], iv[32], plain[kSize];
+	for (auto i = 0; i != 32; ++i) {
+		key[i] = uchar(i * 7 + 3);
+		iv[i] = uchar(i * 13 + 5);
+	}
+	for (auto i = 0; i != kSize; ++i) {
+		plain[i] = uchar(i * 31 + (i >> 3));
+	}
+
+	uchar expected[kSize], computed[kSize];
+	OpenSSLIgeEncrypt(plain, expected, kSize, key, iv);
+	internal::AesNi::IgeEncrypt(plain, computed, kSize, key, iv);
+	if (memcmp(expected, computed, kSize) != 0) {
+		return false;
+	}
+	OpenSSLIgeDecrypt(plain, expected, kSize, key, iv);
+	internal::AesNi::IgeDecrypt(plain, computed, kSize, key, iv);
+	if (memcmp(expected, computed, kSize) != 0) {
+		return false;
+	}
+
+	// Odd chunk sizes go through all the partial block paths.
+	auto expectedState = CTRState();
+	auto computedState = CTRState();
+	memcpy(expectedState.ivec, iv, CTRState::IvecSize);
+	memcpy(computedState.ivec, iv, CTRState::IvecSize);
+	memcpy(expected, plain, kSize);
+	memcpy(computed, plain, kSize);
+	for (auto offset = 0, chunk = 1; offset < kSize; offset += chunk, chunk += 11) {
+		const auto size = std::min(chunk, kSize - offset);
+		OpenSSLCtrEncrypt(bytes::make_span(expected + offset, size), key, &expectedState);
+		AesNiCtrEncrypt(bytes::make_span(computed + offset, size), key, &computedState);
+	}
+	return !memcmp(expected, computed, kSize)
+		&& !memcmp(expectedState.ivec, computedState.ivec, CTRState::IvecSize)
+		&& !memcmp(expectedState.ecount, computedState.ecount, CTRState::EcountSize)
+		&& (expectedState.num == computedState.num);
+}
+
+bool UseAesNi() {
+	static const auto result = [] {
+		if (!internal::AesNi::Supported()) {
+			return false;
+		} else if (!CheckAesNi()) {
+			LOG(("AES Error: AES-NI results differ from OpenSSL, disabling."));
+			return false;
+		}
+		return true;
+	}();
+	return result;
+}
+
+} // namespace
+
+void aesIgeEncryptRaw(const void *src, void *dst, uint32 len, const void *key, const void *iv) {
+	if (UseAesNi()) {
+		internal::AesNi::IgeEncrypt(
+			static_cast<const uchar*>(src),
+			static_cast<uchar*>(dst),
+			len,
+			static_cast<const uchar*>(key),
+			static_cast<const uchar*>(iv));
+	} else {
+		OpenSSLIgeEncrypt(src, dst, len, key, iv);
+	}
+}
+
+void aesIgeDecryptRaw(const void *src, void *dst, uint32 len, const void *key, const void *iv) {
+	if (UseAesNi()) {
+		internal::AesNi::IgeDecrypt(
+			static_cast<const uchar*>(src),
+			static_cast<uchar*>(dst),
+			len,
+			static_cast<const uchar*>(key),
+			static_cast<const uchar*>(iv));
+	} else {
+		OpenSSLIgeDecrypt(src, dst, len, key, iv);
+	}
+}
+
+void aesCtrEncrypt(bytes::span data, const void *key, CTRState *state) {
+	if (UseAesNi()) {
+		AesNiCtrEncrypt(data, key, state);
+	} else {
+		OpenSSLCtrEncrypt(data, key, state);
+	}
+}
+
 } // namespace MTP
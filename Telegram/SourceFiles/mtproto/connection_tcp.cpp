@@ -22,6 +22,14 @@ namespace {
 constexpr auto kPacketSizeMax = 0x01000000 * sizeof(mtpPrime);
 constexpr auto kFullConnectionTimeout = 8 * TimeMs(1000);
 
+// Big packets (like file parts) arrive in a row, so the buffer used
+// for them is kept for the next packet unless it is too large.
+constexpr auto kLongBufferKeepSize = 512 * 1024; // Of ints, 2 mb.
+
+// Receive path counters are written to the tcp log each time so many
+// bytes are received.
+constexpr auto kReceiveStatsLogBytes = uint64(16 * 1024 * 1024);
+
 using ErrorSignal = void(QTcpSocket::*)(QAbstractSocket::SocketError);
 const auto QTcpSocket_error = ErrorSignal(&QAbstractSocket::error);
 
@@ -273,26 +281,16 @@ void TcpConnection::socketRead() {
 		return;
 	}
 
+	// Packets are only queued while reading and the queue is handled
+	// once for the whole chunk instead of once for each packet.
+	const auto wasQueued = _receivedQueue.size();
+	auto receivedBytes = false;
 	do {
-		uint32 toRead = _packetLeft
-			? _packetLeft
-			: (_readingToShort
-				? (kShortBufferSize * sizeof(mtpPrime) - _packetRead)
-				: 4);
-		if (_readingToShort) {
-			if (_currentPosition + toRead > ((char*)_shortBuffer) + kShortBufferSize * sizeof(mtpPrime)) {
-				_longBuffer.resize(((_packetRead + toRead) >> 2) + 1);
-				memcpy(&_longBuffer[0], _shortBuffer, _packetRead);
-				_currentPosition = ((char*)&_longBuffer[0]) + _packetRead;
-				_readingToShort = false;
-			}
-		} else {
-			if (_longBuffer.size() * sizeof(mtpPrime) < _packetRead + toRead) {
-				_longBuffer.resize(((_packetRead + toRead) >> 2) + 1);
-				_currentPosition = ((char*)&_longBuffer[0]) + _packetRead;
-			}
-		}
-		int32 bytes = (int32)_socket.read(_currentPosition, toRead);
+		// The buffer always has room for the whole incomplete packet.
+		Assert(_packetRead < receiveBufferSize());
+		const auto toRead = receiveBufferSize() - _packetRead;
+		const auto bytes = int32(_socket.read(_currentPosition, toRead));
+		++_receiveReads;
 		if (bytes > 0) {
 			aesCtrEncrypt(
 				bytes::make_span(_currentPosition, bytes),
@@ -300,63 +298,12 @@ void TcpConnection::socketRead() {
 				&_receiveState);
 			TCP_LOG(("TCP Info: read %1 bytes").arg(bytes));
 
+			_receivedBytes += bytes;
 			_packetRead += bytes;
 			_currentPosition += bytes;
-			if (_packetLeft) {
-				_packetLeft -= bytes;
-				if (!_packetLeft) {
-					socketPacket(bytes::make_span(
-						_currentPosition - _packetRead,
-						_packetRead));
-					_currentPosition = (char*)_shortBuffer;
-					_packetRead = _packetLeft = 0;
-					_readingToShort = true;
-					_longBuffer.clear();
-				} else {
-					TCP_LOG(("TCP Info: not enough %1 for packet! read %2"
-						).arg(_packetLeft
-						).arg(_packetRead));
-					emit receivedSome();
-				}
-			} else {
-				bool move = false;
-				while (_packetRead >= 4) {
-					const auto packetSize = _protocol->readPacketLength(
-						bytes::make_span(
-							_currentPosition - _packetRead,
-							_packetRead));
-					if (packetSize == Protocol::kUnknownSize
-						|| packetSize == Protocol::kInvalidSize) {
-						LOG(("TCP Error: packet size = %1").arg(packetSize));
-						emit error(kErrorCodeOther);
-						return;
-					}
-					if (_packetRead >= packetSize) {
-						socketPacket(bytes::make_span(
-							_currentPosition - _packetRead,
-							packetSize));
-						_packetRead -= packetSize;
-						_packetLeft = 0;
-						move = true;
-					} else {
-						_packetLeft = packetSize - _packetRead;
-						TCP_LOG(("TCP Info: not enough %1 for packet! size %2 read %3").arg(_packetLeft).arg(packetSize).arg(_packetRead));
-						emit receivedSome();
-						break;
-					}
-				}
-				if (move) {
-					if (!_packetRead) {
-						_currentPosition = (char*)_shortBuffer;
-						_readingToShort = true;
-						_longBuffer.clear();
-					} else if (!_readingToShort && _packetRead < kShortBufferSize * sizeof(mtpPrime)) {
-						memcpy(_shortBuffer, _currentPosition - _packetRead, _packetRead);
-						_currentPosition = (char*)_shortBuffer + _packetRead;
-						_readingToShort = true;
-						_longBuffer.clear();
-					}
-				}
+			receivedBytes = true;
+			if (!socketReadPackets()) {
+				return;
 			}
 		} else if (bytes < 0) {
 			LOG(("TCP Error: socket read return -1"));
@@ -367,6 +314,104 @@ void TcpConnection::socketRead() {
 			break;
 		}
 	} while (_socket.state() == QAbstractSocket::ConnectedState && _socket.bytesAvailable());
+
+	if (_receivedQueue.size() != wasQueued) {
+		emit receivedData();
+	} else if (receivedBytes && _packetRead) {
+		emit receivedSome();
+	}
+	if (_receivedBytes >= _receiveStatsLogged + kReceiveStatsLogBytes) {
+		logReceiveStats();
+	}
+}
+
+bool TcpConnection::socketReadPackets() {
+	auto start = _currentPosition - _packetRead;
+	while (_packetRead >= 4) {
+		const auto packetSize = _protocol->readPacketLength(
+			bytes::make_span(start, _packetRead));
+		if (packetSize == Protocol::kUnknownSize
+			|| packetSize == Protocol::kInvalidSize) {
+			LOG(("TCP Error: packet size = %1").arg(packetSize));
+			emit error(kErrorCodeOther);
+			return false;
+		} else if (_packetRead < packetSize) {
+			_packetLeft = packetSize - _packetRead;
+			TCP_LOG(("TCP Info: not enough %1 for packet! size %2 read %3"
+				).arg(_packetLeft
+				).arg(packetSize
+				).arg(_packetRead));
+			break;
+		}
+		socketPacket(bytes::make_span(start, packetSize));
+		start += packetSize;
+		_packetRead -= packetSize;
+		_packetLeft = 0;
+	}
+
+	// Move the incomplete packet to the beginning of a buffer
+	// large enough to hold it whole, so that it is read in place.
+	const auto required = _packetRead + _packetLeft;
+	const auto switchToShort = [&] {
+		if (!_readingToShort
+			&& _longBuffer.size() > kLongBufferKeepSize) {
+			_longBuffer = mtpBuffer();
+		}
+		_readingToShort = true;
+	};
+	if (!_packetRead) {
+		switchToShort();
+	} else if (required <= kShortBufferSize * sizeof(mtpPrime)) {
+		if (start != reinterpret_cast<char*>(_shortBuffer)) {
+			memmove(_shortBuffer, start, _packetRead);
+		}
+		switchToShort();
+	} else if (_readingToShort) {
+		ensureLongBuffer(required);
+		memcpy(_longBuffer.data(), start, _packetRead);
+		_readingToShort = false;
+	} else {
+		if (start != reinterpret_cast<char*>(_longBuffer.data())) {
+			memmove(_longBuffer.data(), start, _packetRead);
+		}
+		ensureLongBuffer(required);
+	}
+	_currentPosition = receiveBuffer() + _packetRead;
+	return true;
+}
+
+char *TcpConnection::receiveBuffer() {
+	return _readingToShort
+		? reinterpret_cast<char*>(_shortBuffer)
+		: reinterpret_cast<char*>(_longBuffer.data());
+}
+
+uint32 TcpConnection::receiveBufferSize() const {
+	return _readingToShort
+		? (kShortBufferSize * sizeof(mtpPrime))
+		: (_longBuffer.size() * sizeof(mtpPrime));
+}
+
+void TcpConnection::ensureLongBuffer(uint32 size) {
+	const auto ints = int((size + sizeof(mtpPrime) - 1) / sizeof(mtpPrime));
+	if (_longBuffer.size() < ints) {
+		if (_longBuffer.capacity() < ints) {
+			++_receiveAllocations;
+		}
+		_longBuffer.resize(ints);
+		if (!_readingToShort) {
+			_currentPosition = receiveBuffer() + _packetRead;
+		}
+	}
+}
+
+void TcpConnection::logReceiveStats() {
+	const auto megabytes = std::max(_receivedBytes / (1024 * 1024), uint64(1));
+	TCP_LOG(("TCP Info: received %1 bytes, %2 reads and %3 allocations per MB"
+		).arg(_receivedBytes
+		).arg(_receiveReads / megabytes
+		).arg(_receiveAllocations / megabytes));
+	_receiveStatsLogged = _receivedBytes;
 }
 
 mtpBuffer TcpConnection::parsePacket(bytes::const_span bytes) {
@@ -611,7 +656,6 @@ void TcpConnection::socketPacket(bytes::const_span bytes) {
 		// new quickack?..
 	} else if (_status == Status::Ready) {
 		_receivedQueue.push_back(data);
-		emit receivedData();
 	} else if (_status == Status::Waiting) {
 		try {
 			const auto res_pq = readPQFakeReply(data);
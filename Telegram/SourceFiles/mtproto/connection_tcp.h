@@ -50,8 +50,14 @@ private:
 	static constexpr auto kShortBufferSize = 65535; // Of ints, 256 kb.
 
 	void socketRead();
+	bool socketReadPackets();
 	void writeConnectionStart();
 
+	char *receiveBuffer();
+	uint32 receiveBufferSize() const;
+	void ensureLongBuffer(uint32 size);
+	void logReceiveStats();
+
 	void socketPacket(bytes::const_span bytes);
 
 	void socketConnected();
@@ -70,13 +76,19 @@ private:
 	QTcpSocket _socket;
 	uint32 _packetIndex = 0; // sent packet number
 
-	uint32 _packetRead = 0;
-	uint32 _packetLeft = 0; // reading from socket
+	uint32 _packetRead = 0; // received bytes not yet framed into packets
+	uint32 _packetLeft = 0; // bytes missing in the current packet
 	bool _readingToShort = true;
-	mtpBuffer _longBuffer;
+	mtpBuffer _longBuffer; // Kept between big packets.
 	mtpPrime _shortBuffer[kShortBufferSize];
 	char *_currentPosition = nullptr;
 
+	// Counters for the receive path, logged for each received chunk.
+	uint64 _receivedBytes = 0;
+	uint64 _receiveReads = 0;
+	uint64 _receiveAllocations = 0;
+	uint64 _receiveStatsLogged = 0;
+
 	uchar _sendKey[CTRState::KeySize];
 	CTRState _sendState;
 	uchar _receiveKey[CTRState::KeySize];
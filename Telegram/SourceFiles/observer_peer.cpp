@@ -12,22 +12,62 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 namespace Notify {
 namespace {
 
-using SmallUpdatesList = QVector<PeerUpdate>;
-NeverFreedPointer<SmallUpdatesList> SmallUpdates;
-using AllUpdatesList = QMap<PeerData*, PeerUpdate>;
-NeverFreedPointer<AllUpdatesList> AllUpdates;
-
-void StartCallback() {
-	SmallUpdates.createIfNull();
-	AllUpdates.createIfNull();
-}
-void FinishCallback() {
-	SmallUpdates.clear();
-	AllUpdates.clear();
-}
+// Updates collected during the current event loop turn in the order
+// they first appeared, with an index to merge the repeated ones.
+using DelayedUpdatesList = std::vector<PeerUpdate>;
+NeverFreedPointer<DelayedUpdatesList> DelayedUpdates;
+using DelayedUpdateIndicesMap = std::unordered_map<PeerData*, int>;
+NeverFreedPointer<DelayedUpdateIndicesMap> DelayedUpdateIndices;
+
+// Viewers of a single peer are routed by the peer, so that an update
+// reaches only the viewers of its peer instead of all the subscribers.
+struct PeerListener {
+	PeerUpdate::Flags flags;
+	Fn<void(const PeerUpdate&)> handler;
+	bool removed = false;
+};
+using PeerListenersList = std::vector<std::shared_ptr<PeerListener>>;
+using PeerListenersMap = std::unordered_map<PeerData*, PeerListenersList>;
+NeverFreedPointer<PeerListenersMap> PeerListeners;
 
 base::Observable<PeerUpdate, PeerUpdatedHandler> PeerUpdatedObservable;
 
+void RemovePeerListener(
+		not_null<PeerData*> peer,
+		const std::shared_ptr<PeerListener> &listener) {
+	listener->removed = true;
+	if (!PeerListeners) {
+		return;
+	}
+	const auto i = PeerListeners->find(peer);
+	if (i == PeerListeners->end()) {
+		return;
+	}
+	auto &list = i->second;
+	list.erase(ranges::remove(list, listener), end(list));
+	if (list.empty()) {
+		PeerListeners->erase(i);
+	}
+}
+
+void NotifyPeerListeners(const PeerUpdate &update) {
+	if (!PeerListeners) {
+		return;
+	}
+	const auto i = PeerListeners->find(update.peer);
+	if (i == PeerListeners->end()) {
+		return;
+	}
+
+	// Handlers may add or remove listeners of the same peer.
+	const auto list = i->second;
+	for (const auto &listener : list) {
+		if (!listener->removed && (update.flags & listener->flags)) {
+			listener->handler(update);
+		}
+	}
+}
+
 } // namespace
 
 void mergePeerUpdate(PeerUpdate &mergeTo, const PeerUpdate &mergeFrom) {
@@ -40,54 +80,42 @@ void mergePeerUpdate(PeerUpdate &mergeTo, const PeerUpdate &mergeFrom) {
 }
 
 void peerUpdatedDelayed(const PeerUpdate &update) {
-	SmallUpdates.createIfNull();
-	AllUpdates.createIfNull();
+	DelayedUpdates.createIfNull();
+	DelayedUpdateIndices.createIfNull();
 
 	Global::RefHandleDelayedPeerUpdates().call();
 
-	int existingUpdatesCount = SmallUpdates->size();
-	for (int i = 0; i < existingUpdatesCount; ++i) {
-		auto &existingUpdate = (*SmallUpdates)[i];
-		if (existingUpdate.peer == update.peer) {
-			mergePeerUpdate(existingUpdate, update);
-			return;
-		}
-	}
-
-	if (AllUpdates->isEmpty()) {
-		if (existingUpdatesCount < 5) {
-			SmallUpdates->push_back(update);
-		} else {
-			AllUpdates->insert(update.peer, update);
-		}
+	const auto index = int(DelayedUpdates->size());
+	const auto i = DelayedUpdateIndices->emplace(update.peer, index).first;
+	if (i->second != index) {
+		mergePeerUpdate((*DelayedUpdates)[i->second], update);
 	} else {
-		auto it = AllUpdates->find(update.peer);
-		if (it != AllUpdates->cend()) {
-			mergePeerUpdate(it.value(), update);
-			return;
-		}
-		AllUpdates->insert(update.peer, update);
+		DelayedUpdates->push_back(update);
 	}
 }
 
 void peerUpdatedSendDelayed() {
-	if (!SmallUpdates || !AllUpdates || SmallUpdates->empty()) return;
+	if (!DelayedUpdates || DelayedUpdates->empty()) return;
 
-	auto smallList = base::take(*SmallUpdates);
-	auto allList = base::take(*AllUpdates);
-	for (auto &update : smallList) {
-		PeerUpdated().notify(std::move(update), true);
-	}
-	for (auto &update : allList) {
-		PeerUpdated().notify(std::move(update), true);
+	auto updates = base::take(*DelayedUpdates);
+	DelayedUpdateIndices->clear();
+	for (const auto &update : updates) {
+		peerUpdatedNow(update);
 	}
 
-	if (SmallUpdates->isEmpty()) {
-		std::swap(smallList, *SmallUpdates);
-		SmallUpdates->resize(0);
+	// Reuse the allocated memory if no updates were added meanwhile.
+	if (DelayedUpdates->empty()) {
+		updates.clear();
+		std::swap(updates, *DelayedUpdates);
 	}
 }
 
+void peerUpdatedNow(const PeerUpdate &update) {
+	// Global subscribers are notified before the single peer viewers.
+	PeerUpdated().notify(update, true);
+	NotifyPeerListeners(update);
+}
+
 base::Observable<PeerUpdate, PeerUpdatedHandler> &PeerUpdated() {
 	return PeerUpdatedObservable;
 }
@@ -108,11 +136,20 @@ rpl::producer<PeerUpdate> PeerUpdateViewer(
 rpl::producer<PeerUpdate> PeerUpdateViewer(
 		not_null<PeerData*> peer,
 		PeerUpdate::Flags flags) {
-	return PeerUpdateViewer(
-		flags
-	) | rpl::filter([=](const PeerUpdate &update) {
-		return (update.peer == peer);
-	});
+	return [=](const auto &consumer) {
+		auto lifetime = rpl::lifetime();
+		const auto listener = std::make_shared<PeerListener>();
+		listener->flags = flags;
+		listener->handler = [=](const PeerUpdate &update) {
+			consumer.put_next_copy(update);
+		};
+		PeerListeners.createIfNull();
+		(*PeerListeners)[peer].push_back(listener);
+		lifetime.add([=] {
+			RemovePeerListener(peer, listener);
+		});
+		return lifetime;
+	};
 }
 
 rpl::producer<PeerUpdate> PeerUpdateValue(
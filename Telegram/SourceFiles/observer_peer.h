@@ -106,6 +106,10 @@ private:
 };
 base::Observable<PeerUpdate, PeerUpdatedHandler> &PeerUpdated();
 
+// Notifies PeerUpdated() subscribers and PeerUpdateViewer(peer) viewers,
+// updates should never be sent through PeerUpdated().notify() directly.
+void peerUpdatedNow(const PeerUpdate &update);
+
 rpl::producer<PeerUpdate> PeerUpdateViewer(
 	PeerUpdate::Flags flags);
 
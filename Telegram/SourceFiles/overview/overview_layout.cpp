@@ -368,6 +368,11 @@ TextState Photo::getState(
 	return {};
 }
 
+void Photo::clearHeavyPart() {
+	_pix = QPixmap();
+	_goodLoaded = false;
+}
+
 Video::Video(
 	not_null<HistoryItem*> parent,
 	not_null<DocumentData*> video)
@@ -530,6 +535,11 @@ TextState Video::getState(
 	return {};
 }
 
+void Video::clearHeavyPart() {
+	_pix = QPixmap();
+	_thumbLoaded = false;
+}
+
 void Video::updateStatusText() {
 	bool showPause = false;
 	int statusSize = 0;
@@ -1121,6 +1131,10 @@ TextState Document::getState(
 	return {};
 }
 
+void Document::clearHeavyPart() {
+	_thumb = QPixmap();
+}
+
 const style::RoundCheckbox &Document::checkboxStyle() const {
 	return st::overviewSmallCheck;
 }
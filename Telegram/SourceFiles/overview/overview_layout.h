@@ -58,6 +58,10 @@ public:
 	virtual void invalidateCache() {
 	}
 
+	// Drop the prepared pixmaps, they're prepared again on paint.
+	virtual void clearHeavyPart() {
+	}
+
 };
 
 class ItemBase : public AbstractItem {
@@ -207,6 +211,8 @@ public:
 		QPoint point,
 		StateRequest request) const override;
 
+	void clearHeavyPart() override;
+
 private:
 	not_null<PhotoData*> _data;
 	ClickHandlerPtr _link;
@@ -229,6 +235,8 @@ public:
 		QPoint point,
 		StateRequest request) const override;
 
+	void clearHeavyPart() override;
+
 protected:
 	float64 dataProgress() const override;
 	bool dataFinished() const override;
@@ -299,6 +307,8 @@ public:
 		return _data;
 	}
 
+	void clearHeavyPart() override;
+
 protected:
 	float64 dataProgress() const override;
 	bool dataFinished() const override;
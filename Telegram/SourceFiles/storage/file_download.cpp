@@ -253,7 +253,15 @@ void FileLoader::start(bool loadFirst, bool prior) {
 	if (_paused) {
 		_paused = false;
 	}
-	if (_finished || tryLoadLocal()) return;
+	if (_finished) {
+		return;
+	} else if (tryLoadLocal()) {
+		// Loaders started with loadFirst are the visible ones.
+		if (loadFirst && _localTaskId) {
+			Local::prioritizeTask(_localTaskId);
+		}
+		return;
+	}
 
 	if (_fromCloud == LoadFromLocalOnly) {
 		cancel();
@@ -22,7 +22,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 using Storage::ValidateThumbDimensions;
 
-TaskQueue::TaskQueue(TimeMs stopTimeoutMs) {
+TaskQueue::TaskQueue(TimeMs stopTimeoutMs, int threadsCount)
+: _threadsCount(std::max(threadsCount, 1)) {
 	if (stopTimeoutMs > 0) {
 		_stopTimer = new QTimer(this);
 		connect(_stopTimer, SIGNAL(timeout()), this, SLOT(stop()));
@@ -35,10 +36,11 @@ TaskId TaskQueue::addTask(std::unique_ptr<Task> &&task) {
 	const auto result = task->id();
 	{
 		QMutexLocker lock(&_tasksToProcessMutex);
+		task->_queued = getms(true);
 		_tasksToProcess.push_back(std::move(task));
 	}
 
-	wakeThread();
+	wakeThreads();
 
 	return result;
 }
@@ -46,30 +48,48 @@ TaskId TaskQueue::addTask(std::unique_ptr<Task> &&task) {
 void TaskQueue::addTasks(std::vector<std::unique_ptr<Task>> &&tasks) {
 	{
 		QMutexLocker lock(&_tasksToProcessMutex);
+		const auto now = getms(true);
 		for (auto &task : tasks) {
+			task->_queued = now;
 			_tasksToProcess.push_back(std::move(task));
 		}
 	}
 
-	wakeThread();
+	wakeThreads();
 }
 
-void TaskQueue::wakeThread() {
-	if (!_thread) {
-		_thread = new QThread();
+void TaskQueue::wakeThreads() {
+	if (_threads.empty()) {
+		for (auto i = 0; i != _threadsCount; ++i) {
+			const auto thread = new QThread();
+			const auto worker = new TaskQueueWorker(this);
+			worker->moveToThread(thread);
 
-		_worker = new TaskQueueWorker(this);
-		_worker->moveToThread(_thread);
+			connect(this, SIGNAL(taskAdded()), worker, SLOT(onTaskAdded()));
+			connect(worker, SIGNAL(taskProcessed()), this, SLOT(onTaskProcessed()));
 
-		connect(this, SIGNAL(taskAdded()), _worker, SLOT(onTaskAdded()));
-		connect(_worker, SIGNAL(taskProcessed()), this, SLOT(onTaskProcessed()));
-
-		_thread->start();
+			thread->start();
+			_threads.push_back(thread);
+			_workers.push_back(worker);
+		}
 	}
 	if (_stopTimer) _stopTimer->stop();
 	emit taskAdded();
 }
 
+void TaskQueue::prioritizeTask(TaskId id) {
+	QMutexLocker lock(&_tasksToProcessMutex);
+	const auto proj = [](const std::unique_ptr<Task> &task) {
+		return task->id();
+	};
+	const auto i = ranges::find(_tasksToProcess, id, proj);
+	if (i != _tasksToProcess.end() && i != _tasksToProcess.begin()) {
+		auto task = std::move(*i);
+		_tasksToProcess.erase(i);
+		_tasksToProcess.push_front(std::move(task));
+	}
+}
+
 void TaskQueue::cancelTask(TaskId id) {
 	const auto removeFrom = [&](std::deque<std::unique_ptr<Task>> &queue) {
 		const auto proj = [](const std::unique_ptr<Task> &task) {
@@ -83,14 +103,36 @@ void TaskQueue::cancelTask(TaskId id) {
 	{
 		QMutexLocker lock(&_tasksToProcessMutex);
 		removeFrom(_tasksToProcess);
-		if (_taskInProcessId == id) {
-			_taskInProcessId = TaskId();
-		}
+		processedTaskInProcess(id);
 	}
 	QMutexLocker lock(&_tasksToFinishMutex);
 	removeFrom(_tasksToFinish);
 }
 
+std::unique_ptr<Task> TaskQueue::takeTaskToProcess() {
+	if (_tasksToProcess.empty()) {
+		return nullptr;
+	}
+	auto result = std::move(_tasksToProcess.front());
+	_tasksToProcess.pop_front();
+	_tasksInProcess.push_back(result->id());
+
+	const auto waited = getms(true) - result->_queued;
+	++_waitedCount;
+	_waitedTotal += waited;
+	accumulate_max(_waitedMax, waited);
+	return result;
+}
+
+bool TaskQueue::processedTaskInProcess(TaskId id) {
+	const auto i = ranges::find(_tasksInProcess, id);
+	if (i == _tasksInProcess.end()) {
+		return false;
+	}
+	_tasksInProcess.erase(i);
+	return true;
+}
+
 void TaskQueue::onTaskProcessed() {
 	do {
 		auto task = std::unique_ptr<Task>();
@@ -103,28 +145,44 @@ void TaskQueue::onTaskProcessed() {
 		task->finish();
 	} while (true);
 
-	if (_stopTimer) {
-		QMutexLocker lock(&_tasksToProcessMutex);
-		if (_tasksToProcess.empty() && !_taskInProcessId) {
+	QMutexLocker lock(&_tasksToProcessMutex);
+	if (_tasksToProcess.empty() && _tasksInProcess.empty()) {
+		if (_waitedCount > 0) {
+			DEBUG_LOG(("Task Queue Info: %1 tasks on %2 threads, "
+				"waited %3 ms on average, %4 ms at most."
+				).arg(_waitedCount
+				).arg(_threadsCount
+				).arg(_waitedTotal / _waitedCount
+				).arg(_waitedMax));
+			_waitedCount = 0;
+			_waitedTotal = _waitedMax = 0;
+		}
+		if (_stopTimer) {
 			_stopTimer->start();
 		}
 	}
 }
 
 void TaskQueue::stop() {
-	if (_thread) {
-		_thread->requestInterruption();
-		_thread->quit();
+	for (const auto thread : _threads) {
+		thread->requestInterruption();
+		thread->quit();
+	}
+	if (!_threads.empty()) {
 		DEBUG_LOG(("Waiting for taskThread to finish"));
-		_thread->wait();
-		delete _worker;
-		delete _thread;
-		_worker = 0;
-		_thread = 0;
+	}
+	for (const auto thread : _threads) {
+		thread->wait();
+	}
+	for (const auto worker : base::take(_workers)) {
+		delete worker;
+	}
+	for (const auto thread : base::take(_threads)) {
+		delete thread;
 	}
 	_tasksToProcess.clear();
 	_tasksToFinish.clear();
-	_taskInProcessId = TaskId();
+	_tasksInProcess.clear();
 }
 
 TaskQueue::~TaskQueue() {
@@ -141,11 +199,7 @@ void TaskQueueWorker::onTaskAdded() {
 		auto task = std::unique_ptr<Task>();
 		{
 			QMutexLocker lock(&_queue->_tasksToProcessMutex);
-			if (!_queue->_tasksToProcess.empty()) {
-				task = std::move(_queue->_tasksToProcess.front());
-				_queue->_tasksToProcess.pop_front();
-				_queue->_taskInProcessId = task->id();
-			}
+			task = _queue->takeTaskToProcess();
 		}
 
 		if (task) {
@@ -153,10 +207,8 @@ void TaskQueueWorker::onTaskAdded() {
 			bool emitTaskProcessed = false;
 			{
 				QMutexLocker lockToProcess(&_queue->_tasksToProcessMutex);
-				if (_queue->_taskInProcessId == task->id()) {
-					_queue->_taskInProcessId = TaskId();
-					someTasksLeft = !_queue->_tasksToProcess.empty();
-
+				someTasksLeft = !_queue->_tasksToProcess.empty();
+				if (_queue->processedTaskInProcess(task->id())) {
 					QMutexLocker lockToFinish(&_queue->_tasksToFinishMutex);
 					emitTaskProcessed = _queue->_tasksToFinish.empty();
 					_queue->_tasksToFinish.push_back(std::move(task));
@@ -165,6 +217,9 @@ void TaskQueueWorker::onTaskAdded() {
 			if (emitTaskProcessed) {
 				emit taskProcessed();
 			}
+		} else {
+			// Another worker took the last task.
+			someTasksLeft = false;
 		}
 		QCoreApplication::processEvents();
 	} while (someTasksLeft && !thread()->isInterruptionRequested());
@@ -539,32 +594,58 @@ void FileLoadTask::process() {
 		auto w = fullimage.width(), h = fullimage.height();
 		attributes.push_back(MTP_documentAttributeImageSize(MTP_int(w), MTP_int(h)));
 
+		// The document thumbnail is scaled from the smallest image we have.
+		auto thumbSource = fullimage;
 		if (ValidateThumbDimensions(w, h)) {
 			if (isAnimation) {
 				attributes.push_back(MTP_documentAttributeAnimated());
 			} else if (_type != SendMediaType::File) {
-				auto thumb = (w > 100 || h > 100) ? App::pixmapFromImageInPlace(fullimage.scaled(100, 100, Qt::KeepAspectRatio, Qt::SmoothTransformation)) : QPixmap::fromImage(fullimage);
-				photoThumbs.insert('s', thumb);
-				photoSizes.push_back(MTP_photoSize(MTP_string("s"), MTP_fileLocationUnavailable(MTP_long(0), MTP_int(0), MTP_long(0)), MTP_int(thumb.width()), MTP_int(thumb.height()), MTP_int(0)));
-
-				auto medium = (w > 320 || h > 320) ? App::pixmapFromImageInPlace(fullimage.scaled(320, 320, Qt::KeepAspectRatio, Qt::SmoothTransformation)) : QPixmap::fromImage(fullimage);
-				photoThumbs.insert('m', medium);
-				photoSizes.push_back(MTP_photoSize(MTP_string("m"), MTP_fileLocationUnavailable(MTP_long(0), MTP_int(0), MTP_long(0)), MTP_int(medium.width()), MTP_int(medium.height()), MTP_int(0)));
-
-				auto full = (w > 1280 || h > 1280) ? App::pixmapFromImageInPlace(fullimage.scaled(1280, 1280, Qt::KeepAspectRatio, Qt::SmoothTransformation)) : QPixmap::fromImage(fullimage);
-				photoThumbs.insert('y', full);
-				photoSizes.push_back(MTP_photoSize(MTP_string("y"), MTP_fileLocationUnavailable(MTP_long(0), MTP_int(0), MTP_long(0)), MTP_int(full.width()), MTP_int(full.height()), MTP_int(0)));
+				const auto started = getms(true);
+
+				// The original image is scaled down only once, the 320 and
+				// 100 sizes are scaled from the result, not from each other.
+				// Only the 90 document thumbnail is scaled from the 320 one.
+				const auto scaled = [](const QImage &image, int size) {
+					return (image.width() > size || image.height() > size)
+						? image.scaled(size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation)
+						: image;
+				};
+				auto full = scaled(fullimage, 1280);
+				auto medium = scaled(full, 320);
+				auto small = scaled(full, 100);
+				thumbSource = medium;
+				const auto scaledAt = getms(true);
 
 				{
 					QBuffer buffer(&filedata);
 					full.save(&buffer, "JPG", 87);
 				}
+				const auto encodedAt = getms(true);
+
+				const auto thumb = App::pixmapFromImageInPlace(std::move(small));
+				photoThumbs.insert('s', thumb);
+				photoSizes.push_back(MTP_photoSize(MTP_string("s"), MTP_fileLocationUnavailable(MTP_long(0), MTP_int(0), MTP_long(0)), MTP_int(thumb.width()), MTP_int(thumb.height()), MTP_int(0)));
+
+				photoThumbs.insert('m', App::pixmapFromImageInPlace(std::move(medium)));
+				photoSizes.push_back(MTP_photoSize(MTP_string("m"), MTP_fileLocationUnavailable(MTP_long(0), MTP_int(0), MTP_long(0)), MTP_int(thumbSource.width()), MTP_int(thumbSource.height()), MTP_int(0)));
+
+				const auto fullWidth = full.width();
+				const auto fullHeight = full.height();
+				photoThumbs.insert('y', App::pixmapFromImageInPlace(std::move(full)));
+				photoSizes.push_back(MTP_photoSize(MTP_string("y"), MTP_fileLocationUnavailable(MTP_long(0), MTP_int(0), MTP_long(0)), MTP_int(fullWidth), MTP_int(fullHeight), MTP_int(0)));
 
 				photo = MTP_photo(MTP_flags(0), MTP_long(_id), MTP_long(0), MTP_int(unixtime()), MTP_vector<MTPPhotoSize>(photoSizes));
 
 				if (filesize < 0) {
 					filesize = _result->filesize = filedata.size();
 				}
+				DEBUG_LOG(("Photo Info: prepared %1x%2 in %3 ms "
+					"(scale %4 ms, encode %5 ms)."
+					).arg(w
+					).arg(h
+					).arg(getms(true) - started
+					).arg(scaledAt - started
+					).arg(encodedAt - scaledAt));
 			}
 
 			QByteArray thumbFormat = "JPG";
@@ -581,7 +662,7 @@ void FileLoadTask::process() {
 				thumbname = qsl("thumb.webp");
 			}
 
-			QPixmap full = (w > 90 || h > 90) ? App::pixmapFromImageInPlace(fullimage.scaled(90, 90, Qt::KeepAspectRatio, Qt::SmoothTransformation)) : QPixmap::fromImage(fullimage, Qt::ColorOnly);
+			QPixmap full = (w > 90 || h > 90) ? App::pixmapFromImageInPlace(thumbSource.scaled(90, 90, Qt::KeepAspectRatio, Qt::SmoothTransformation)) : QPixmap::fromImage(fullimage, Qt::ColorOnly);
 
 			{
 				QBuffer buffer(&thumbdata);
@@ -101,6 +101,12 @@ public:
 		return static_cast<TaskId>(const_cast<Task*>(this));
 	}
 
+private:
+	friend class TaskQueue;
+	friend class TaskQueueWorker;
+
+	TimeMs _queued = 0;
+
 };
 
 class TaskQueueWorker;
@@ -108,10 +114,13 @@ class TaskQueue : public QObject {
 	Q_OBJECT
 
 public:
-	explicit TaskQueue(TimeMs stopTimeoutMs = 0); // <= 0 - never stop worker
+	// stopTimeoutMs <= 0 - never stop workers.
+	// With several threads tasks may be finished not in the added order.
+	explicit TaskQueue(TimeMs stopTimeoutMs = 0, int threadsCount = 1);
 
 	TaskId addTask(std::unique_ptr<Task> &&task);
 	void addTasks(std::vector<std::unique_ptr<Task>> &&tasks);
+	void prioritizeTask(TaskId id); // process this task before the others
 	void cancelTask(TaskId id); // this task finish() won't be called
 
 	~TaskQueue();
@@ -126,16 +135,26 @@ public slots:
 private:
 	friend class TaskQueueWorker;
 
-	void wakeThread();
+	void wakeThreads();
+
+	// Called by workers with _tasksToProcessMutex locked.
+	std::unique_ptr<Task> takeTaskToProcess();
+	bool processedTaskInProcess(TaskId id);
 
 	std::deque<std::unique_ptr<Task>> _tasksToProcess;
 	std::deque<std::unique_ptr<Task>> _tasksToFinish;
-	TaskId _taskInProcessId = TaskId();
+	std::vector<TaskId> _tasksInProcess;
 	QMutex _tasksToProcessMutex, _tasksToFinishMutex;
-	QThread *_thread = nullptr;
-	TaskQueueWorker *_worker = nullptr;
+	int _threadsCount = 1;
+	std::vector<QThread*> _threads;
+	std::vector<TaskQueueWorker*> _workers;
 	QTimer *_stopTimer = nullptr;
 
+	// Time tasks spent waiting for a worker, guarded by _tasksToProcessMutex.
+	int _waitedCount = 0;
+	TimeMs _waitedTotal = 0;
+	TimeMs _waitedMax = 0;
+
 };
 
 class TaskQueueWorker : public QObject {
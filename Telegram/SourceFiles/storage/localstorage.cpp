@@ -31,6 +31,9 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_session.h"
 #include "history/history.h"
 
+#include <mutex>
+#include <condition_variable>
+
 extern "C" {
 #include <openssl/evp.h>
 } // extern "C"
@@ -40,8 +43,10 @@ namespace {
 
 constexpr auto kThemeFileSizeLimit = 5 * 1024 * 1024;
 constexpr auto kFileLoaderQueueStopTimeout = TimeMs(5000);
+constexpr auto kLocalLoaderThreadsLimit = 4;
 constexpr auto kDefaultStickerInstallDate = TimeId(1);
 constexpr auto kProxyTypeShift = 1024;
+constexpr auto kStoredWaveformsLimit = 512;
 
 using FileKey = quint64;
 
@@ -110,7 +115,38 @@ FileKey genKey(FileOptions options = FileOption::User | FileOption::Safe) {
 	return result;
 }
 
+// Session files are read and decrypted on worker threads right after
+// the map is read and are deserialized on the main thread later.
+struct PrefetchedFile {
+	std::mutex mutex;
+	std::condition_variable finished;
+	bool ready = false;
+	bool success = false;
+	int32 version = 0;
+	QByteArray data;
+	qint64 position = 0;
+	TimeMs duration = 0;
+};
+base::flat_map<FileKey, std::shared_ptr<PrefetchedFile>> _prefetchedFiles;
+TimeMs _prefetchStarted = 0;
+
+void waitPrefetchedFile(const std::shared_ptr<PrefetchedFile> &file) {
+	std::unique_lock<std::mutex> lock(file->mutex);
+	file->finished.wait(lock, [&] { return file->ready; });
+}
+
+// The file is going to be changed, so the prefetched data is outdated.
+void dropPrefetchedFile(const FileKey &key) {
+	const auto i = _prefetchedFiles.find(key);
+	if (i != _prefetchedFiles.end()) {
+		const auto file = std::move(i->second);
+		_prefetchedFiles.erase(i);
+		waitPrefetchedFile(file);
+	}
+}
+
 void clearKey(const FileKey &key, FileOptions options = FileOption::User | FileOption::Safe) {
+	dropPrefetchedFile(key);
 	if (options & FileOption::User) {
 		if (!_userWorking()) return;
 	} else {
@@ -205,6 +241,7 @@ struct EncryptedDescriptor {
 
 struct FileWriteDescriptor {
 	FileWriteDescriptor(const FileKey &key, FileOptions options = FileOption::User | FileOption::Safe) {
+		dropPrefetchedFile(key);
 		init(toFilePart(key), options);
 	}
 	FileWriteDescriptor(const QString &name, FileOptions options = FileOption::User | FileOption::Safe) {
@@ -446,15 +483,57 @@ bool decryptLocal(EncryptedDescriptor &result, const QByteArray &encrypted, cons
 	return true;
 }
 
+// Same as decryptLocal, but decrypts the encrypted part right inside
+// the buffer it was read to, without copying it anywhere.
+bool decryptLocalInPlace(FileReadDescriptor &result, const MTP::AuthKeyPtr &key) {
+	auto encryptedSize = quint32(0);
+	result.stream >> encryptedSize;
+	const auto offset = int(result.buffer.pos());
+	if (result.stream.status() != QDataStream::Ok
+		|| encryptedSize <= 16
+		|| (encryptedSize & 0x0F)
+		|| encryptedSize > uint32(result.data.size() - offset)) {
+		LOG(("App Error: bad encrypted part size: %1").arg(encryptedSize));
+		return false;
+	}
+	const auto fullLen = uint32(encryptedSize - 16);
+
+	result.stream.setDevice(0);
+	result.buffer.close();
+	result.buffer.setBuffer(0);
+
+	const auto encryptedKey = result.data.data() + offset;
+	const auto decrypted = encryptedKey + 16;
+	aesDecryptLocal(decrypted, decrypted, fullLen, key, encryptedKey);
+	uchar sha1Buffer[20];
+	if (memcmp(hashSha1(decrypted, fullLen, sha1Buffer), encryptedKey, 16)) {
+		LOG(("App Info: bad decrypt key, data not decrypted - incorrect password?"));
+		return false;
+	}
+
+	uint32 dataLen = *(const uint32*)decrypted;
+	if (dataLen > fullLen || dataLen <= fullLen - 16 || dataLen < sizeof(uint32)) {
+		LOG(("App Error: bad decrypted part size: %1, fullLen: %2").arg(dataLen).arg(fullLen));
+		return false;
+	}
+
+	memmove(result.data.data(), decrypted, dataLen);
+	result.data.resize(dataLen);
+
+	result.buffer.setBuffer(&result.data);
+	result.buffer.open(QIODevice::ReadOnly);
+	result.buffer.seek(sizeof(uint32)); // skip len
+	result.stream.setDevice(&result.buffer);
+	result.stream.setVersion(QDataStream::Qt_5_1);
+
+	return true;
+}
+
 bool readEncryptedFile(FileReadDescriptor &result, const QString &name, FileOptions options = FileOption::User | FileOption::Safe, const MTP::AuthKeyPtr &key = LocalKey) {
 	if (!readFile(result, name, options)) {
 		return false;
 	}
-	QByteArray encrypted;
-	result.stream >> encrypted;
-
-	EncryptedDescriptor data;
-	if (!decryptLocal(data, encrypted, key)) {
+	if (!decryptLocalInPlace(result, key)) {
 		result.stream.setDevice(0);
 		if (result.buffer.isOpen()) result.buffer.close();
 		result.buffer.setBuffer(0);
@@ -462,24 +541,76 @@ bool readEncryptedFile(FileReadDescriptor &result, const QString &name, FileOpti
 		result.version = 0;
 		return false;
 	}
+	return true;
+}
 
-	result.stream.setDevice(0);
-	if (result.buffer.isOpen()) result.buffer.close();
-	result.buffer.setBuffer(0);
-	result.data = data.data;
+bool readEncryptedFile(FileReadDescriptor &result, const FileKey &fkey, FileOptions options = FileOption::User | FileOption::Safe, const MTP::AuthKeyPtr &key = LocalKey) {
+	return readEncryptedFile(result, toFilePart(fkey), options, key);
+}
+
+void prefetchEncryptedFile(const FileKey &key) {
+	if (!key || _prefetchedFiles.contains(key)) {
+		return;
+	}
+	const auto file = std::make_shared<PrefetchedFile>();
+	_prefetchedFiles.emplace(key, file);
+	crl::async([=] {
+		const auto started = getms(true);
+		FileReadDescriptor result;
+		const auto success = readEncryptedFile(result, key);
+
+		std::unique_lock<std::mutex> lock(file->mutex);
+		file->success = success;
+		if (success) {
+			file->version = result.version;
+			file->data = result.data;
+			file->position = result.buffer.pos();
+		}
+		file->duration = getms(true) - started;
+		file->ready = true;
+		lock.unlock();
+
+		file->finished.notify_all();
+	});
+}
+
+void clearPrefetchedFiles() {
+	for (const auto &[key, file] : base::take(_prefetchedFiles)) {
+		waitPrefetchedFile(file);
+	}
+}
+
+// Takes the prefetched file if there is one, waiting for it if needed.
+bool readSessionFile(FileReadDescriptor &result, const FileKey &key) {
+	const auto i = _prefetchedFiles.find(key);
+	if (i == _prefetchedFiles.end()) {
+		return readEncryptedFile(result, key);
+	}
+	const auto file = std::move(i->second);
+	_prefetchedFiles.erase(i);
+
+	const auto waitStarted = getms(true);
+	waitPrefetchedFile(file);
+	const auto now = getms(true);
+	DEBUG_LOG(("App Info: session file %1 read in %2 ms, "
+		"waited %3 ms, taken %4 ms after the map"
+		).arg(toFilePart(key)
+		).arg(file->duration
+		).arg(now - waitStarted
+		).arg(now - _prefetchStarted));
+	if (!file->success) {
+		return false;
+	}
+	result.version = file->version;
+	result.data = file->data;
 	result.buffer.setBuffer(&result.data);
 	result.buffer.open(QIODevice::ReadOnly);
-	result.buffer.seek(data.buffer.pos());
+	result.buffer.seek(file->position);
 	result.stream.setDevice(&result.buffer);
 	result.stream.setVersion(QDataStream::Qt_5_1);
-
 	return true;
 }
 
-bool readEncryptedFile(FileReadDescriptor &result, const FileKey &fkey, FileOptions options = FileOption::User | FileOption::Safe, const MTP::AuthKeyPtr &key = LocalKey) {
-	return readEncryptedFile(result, toFilePart(fkey), options, key);
-}
-
 FileKey _dataNameKey = 0;
 
 enum { // Local Storage Keys
@@ -503,6 +634,7 @@ enum { // Local Storage Keys
 	lskTrustedBots = 0x11, // no data
 	lskFavedStickers = 0x12, // no data
 	lskExportSettings = 0x13, // no data
+	lskWaveforms = 0x14, // no data
 };
 
 enum {
@@ -639,6 +771,11 @@ bool _recentHashtagsAndBotsWereRead = false;
 
 FileKey _exportSettingsKey = 0;
 
+FileKey _waveformsKey = 0;
+QMap<DocumentId, VoiceWaveform> _waveforms;
+std::deque<DocumentId> _waveformsOrder;
+bool _waveformsRead = false;
+
 FileKey _savedPeersKey = 0;
 FileKey _langPackKey = 0;
 
@@ -2079,6 +2216,7 @@ ReadMapState _readMap(const QByteArray &pass) {
 	quint64 installedStickersKey = 0, featuredStickersKey = 0, recentStickersKey = 0, favedStickersKey = 0, archivedStickersKey = 0;
 	quint64 savedGifsKey = 0;
 	quint64 backgroundKey = 0, userSettingsKey = 0, recentHashtagsAndBotsKey = 0, savedPeersKey = 0, exportSettingsKey = 0;
+	quint64 waveformsKey = 0;
 	while (!map.stream.atEnd()) {
 		quint32 keyType;
 		map.stream >> keyType;
@@ -2183,6 +2321,9 @@ ReadMapState _readMap(const QByteArray &pass) {
 		case lskExportSettings: {
 			map.stream >> exportSettingsKey;
 		} break;
+		case lskWaveforms: {
+			map.stream >> waveformsKey;
+		} break;
 		default:
 		LOG(("App Error: unknown key type in encrypted map: %1").arg(keyType));
 		return ReadMapFailed;
@@ -2218,6 +2359,7 @@ ReadMapState _readMap(const QByteArray &pass) {
 	_userSettingsKey = userSettingsKey;
 	_recentHashtagsAndBotsKey = recentHashtagsAndBotsKey;
 	_exportSettingsKey = exportSettingsKey;
+	_waveformsKey = waveformsKey;
 	_oldMapVersion = mapData.version;
 	if (_oldMapVersion < AppVersion) {
 		_mapChanged = true;
@@ -2226,6 +2368,15 @@ ReadMapState _readMap(const QByteArray &pass) {
 		_mapChanged = false;
 	}
 
+	// Read the files used in MainWidget::start while the rest is loading.
+	_prefetchStarted = getms(true);
+	prefetchEncryptedFile(_savedPeersKey);
+	prefetchEncryptedFile(_installedStickersKey);
+	prefetchEncryptedFile(_featuredStickersKey);
+	prefetchEncryptedFile(_recentStickersKey);
+	prefetchEncryptedFile(_favedStickersKey);
+	prefetchEncryptedFile(_savedGifsKey);
+
 	if (_locationsKey) {
 		_readLocations();
 	}
@@ -2297,6 +2448,7 @@ void _writeMap(WriteMapWhen when) {
 	if (_userSettingsKey) mapSize += sizeof(quint32) + sizeof(quint64);
 	if (_recentHashtagsAndBotsKey) mapSize += sizeof(quint32) + sizeof(quint64);
 	if (_exportSettingsKey) mapSize += sizeof(quint32) + sizeof(quint64);
+	if (_waveformsKey) mapSize += sizeof(quint32) + sizeof(quint64);
 
 	if (mapSize > 30 * 1024 * 1024) {
 		CrashReports::SetAnnotation("MapSize", QString("%1,%2,%3,%4,%5"
@@ -2377,6 +2529,9 @@ void _writeMap(WriteMapWhen when) {
 	if (_exportSettingsKey) {
 		mapData.stream << quint32(lskExportSettings) << quint64(_exportSettingsKey);
 	}
+	if (_waveformsKey) {
+		mapData.stream << quint32(lskWaveforms) << quint64(_waveformsKey);
+	}
 	map.writeEncrypted(mapData);
 
 	_mapChanged = false;
@@ -2405,7 +2560,9 @@ void start() {
 	Expects(!_manager);
 
 	_manager = new internal::Manager();
-	_localLoader = new TaskQueue(kFileLoaderQueueStopTimeout);
+	_localLoader = new TaskQueue(
+		kFileLoaderQueueStopTimeout,
+		snap(QThread::idealThreadCount() - 1, 1, kLocalLoaderThreadsLimit));
 
 	_basePath = cWorkingDir() + qsl("tdata/");
 	if (!QDir().exists(_basePath)) QDir().mkpath(_basePath);
@@ -2618,6 +2775,7 @@ void reset() {
 	if (_localLoader) {
 		_localLoader->stop();
 	}
+	clearPrefetchedFiles();
 
 	_passKeySalt.clear(); // reset passcode, local key
 	_draftsMap.clear();
@@ -2637,6 +2795,10 @@ void reset() {
 	_installedStickersKey = _featuredStickersKey = _recentStickersKey = _favedStickersKey = _archivedStickersKey = 0;
 	_savedGifsKey = 0;
 	_backgroundKey = _userSettingsKey = _recentHashtagsAndBotsKey = _savedPeersKey = _exportSettingsKey = 0;
+	_waveformsKey = 0;
+	_waveforms.clear();
+	_waveformsOrder.clear();
+	_waveformsRead = false;
 	_oldMapVersion = _oldSettingsVersion = 0;
 	StoredAuthSessionCache.reset();
 	_mapChanged = true;
@@ -3347,6 +3509,104 @@ qint64 storageWebFilesSize() {
 	return _storageWebFilesSize;
 }
 
+void _writeWaveforms(WriteMapWhen when = WriteMapWhen::Soon) {
+	if (when != WriteMapWhen::Now) {
+		_manager->writeWaveforms(when == WriteMapWhen::Fast);
+		return;
+	}
+	if (!_working()) return;
+
+	_manager->writingWaveforms();
+	if (_waveforms.isEmpty()) {
+		if (_waveformsKey) {
+			clearKey(_waveformsKey);
+			_waveformsKey = 0;
+			_mapChanged = true;
+			_writeMap();
+		}
+		return;
+	}
+	if (!_waveformsKey) {
+		_waveformsKey = genKey();
+		_mapChanged = true;
+		_writeMap(WriteMapWhen::Fast);
+	}
+	quint32 size = sizeof(qint32);
+	for (const auto id : _waveformsOrder) {
+		size += sizeof(quint64) + sizeof(quint32) + _waveforms.value(id).size();
+	}
+	EncryptedDescriptor data(size);
+	data.stream << qint32(_waveformsOrder.size());
+	for (const auto id : _waveformsOrder) {
+		const auto &waveform = _waveforms.value(id);
+		data.stream
+			<< quint64(id)
+			<< QByteArray(waveform.constData(), waveform.size());
+	}
+
+	FileWriteDescriptor file(_waveformsKey);
+	file.writeEncrypted(data);
+}
+
+void _readWaveforms() {
+	if (!_waveformsKey) return;
+
+	FileReadDescriptor waveforms;
+	if (!readEncryptedFile(waveforms, _waveformsKey)) {
+		clearKey(_waveformsKey);
+		_waveformsKey = 0;
+		_writeMap();
+		return;
+	}
+
+	qint32 count = 0;
+	waveforms.stream >> count;
+	for (auto i = 0; i != count; ++i) {
+		quint64 id = 0;
+		QByteArray bytes;
+		waveforms.stream >> id >> bytes;
+		if (!_checkStreamStatus(waveforms.stream)) {
+			break;
+		}
+		if (bytes.isEmpty() || _waveforms.contains(id)) {
+			continue;
+		}
+		_waveforms.insert(id, VoiceWaveform(bytes.begin(), bytes.end()));
+		_waveformsOrder.push_back(id);
+	}
+}
+
+const VoiceWaveform *_lookupWaveform(DocumentId id) {
+	if (!_waveformsRead) {
+		_readWaveforms();
+		_waveformsRead = true;
+	}
+	const auto i = _waveforms.constFind(id);
+	return (i != _waveforms.cend()) ? &i.value() : nullptr;
+}
+
+void _storeWaveform(DocumentId id, const VoiceWaveform &waveform) {
+	if (waveform.isEmpty() || _lookupWaveform(id)) {
+		return;
+	}
+	_waveforms.insert(id, waveform);
+	_waveformsOrder.push_back(id);
+	while (int(_waveformsOrder.size()) > kStoredWaveformsLimit) {
+		_waveforms.remove(_waveformsOrder.front());
+		_waveformsOrder.pop_front();
+	}
+	_writeWaveforms();
+}
+
+char _countWavemax(const VoiceWaveform &waveform) {
+	uchar wavemax = 0;
+	for (int32 i = 0, l = waveform.size(); i < l; ++i) {
+		uchar waveat = waveform.at(i);
+		if (wavemax < waveat) wavemax = waveat;
+	}
+	return wavemax;
+}
+
 class CountWaveformTask : public Task {
 public:
 	CountWaveformTask(DocumentData *doc)
@@ -3362,18 +3622,14 @@ public:
 		if (!_doc) return;
 
 		_waveform = audioCountWaveform(_loc, _data);
-		uchar wavemax = 0;
-		for (int32 i = 0, l = _waveform.size(); i < l; ++i) {
-			uchar waveat = _waveform.at(i);
-			if (wavemax < waveat) wavemax = waveat;
-		}
-		_wavemax = wavemax;
+		_wavemax = _countWavemax(_waveform);
 	}
 	void finish() {
 		if (const auto voice = _doc ? _doc->voice() : nullptr) {
 			if (!_waveform.isEmpty()) {
 				voice->waveform = _waveform;
 				voice->wavemax = _wavemax;
+				_storeWaveform(_doc->id, _waveform);
 			}
 			if (voice->waveform.isEmpty()) {
 				voice->waveform.resize(1);
@@ -3403,6 +3659,15 @@ protected:
 
 void countVoiceWaveform(DocumentData *document) {
 	if (const auto voice = document->voice()) {
+		if (!voice->waveform.isEmpty() && voice->waveform[0] == -1) {
+			return; // already counting
+		}
+		if (const auto stored = _lookupWaveform(document->id)) {
+			voice->waveform = *stored;
+			voice->wavemax = _countWavemax(*stored);
+			Auth().data().requestDocumentViewRepaint(document);
+			return;
+		}
 		if (_localLoader) {
 			voice->waveform.resize(1 + sizeof(TaskId));
 			voice->waveform[0] = -1; // counting
@@ -3413,6 +3678,12 @@ void countVoiceWaveform(DocumentData *document) {
 	}
 }
 
+void prioritizeTask(TaskId id) {
+	if (_localLoader) {
+		_localLoader->prioritizeTask(id);
+	}
+}
+
 void cancelTask(TaskId id) {
 	if (_localLoader) {
 		_localLoader->cancelTask(id);
@@ -3560,7 +3831,7 @@ void _writeStickerSets(FileKey &stickersKey, CheckSet checkSet, const Stickers::
 
 void _readStickerSets(FileKey &stickersKey, Stickers::Order *outOrder = nullptr, MTPDstickerSet::Flags readingFlags = 0) {
 	FileReadDescriptor stickers;
-	if (!readEncryptedFile(stickers, stickersKey)) {
+	if (!readSessionFile(stickers, stickersKey)) {
 		clearKey(stickersKey);
 		stickersKey = 0;
 		_writeMap();
@@ -4072,7 +4343,7 @@ void readSavedGifs() {
 	if (!_savedGifsKey) return;
 
 	FileReadDescriptor gifs;
-	if (!readEncryptedFile(gifs, _savedGifsKey)) {
+	if (!readSessionFile(gifs, _savedGifsKey)) {
 		clearKey(_savedGifsKey);
 		_savedGifsKey = 0;
 		_writeMap();
@@ -4825,7 +5096,7 @@ void readSavedPeers() {
 	if (!_savedPeersKey) return;
 
 	FileReadDescriptor saved;
-	if (!readEncryptedFile(saved, _savedPeersKey)) {
+	if (!readSessionFile(saved, _savedPeersKey)) {
 		clearKey(_savedPeersKey);
 		_savedPeersKey = 0;
 		_writeMap();
@@ -5040,6 +5311,12 @@ bool ClearManager::addTask(int task) {
 			_savedPeersKey = 0;
 			_mapChanged = true;
 		}
+		if (_waveformsKey) {
+			_waveformsKey = 0;
+			_waveforms.clear();
+			_waveformsOrder.clear();
+			_mapChanged = true;
+		}
 		_writeMap();
 	} else {
 		if (task & ClearManagerStorage) {
@@ -5228,6 +5505,8 @@ Manager::Manager() {
 	connect(&_mapWriteTimer, SIGNAL(timeout()), this, SLOT(mapWriteTimeout()));
 	_locationsWriteTimer.setSingleShot(true);
 	connect(&_locationsWriteTimer, SIGNAL(timeout()), this, SLOT(locationsWriteTimeout()));
+	_waveformsWriteTimer.setSingleShot(true);
+	connect(&_waveformsWriteTimer, SIGNAL(timeout()), this, SLOT(waveformsWriteTimeout()));
 }
 
 void Manager::writeMap(bool fast) {
@@ -5254,6 +5533,18 @@ void Manager::writingLocations() {
 	_locationsWriteTimer.stop();
 }
 
+void Manager::writeWaveforms(bool fast) {
+	if (!_waveformsWriteTimer.isActive() || fast) {
+		_waveformsWriteTimer.start(fast ? 1 : WriteMapTimeout);
+	} else if (_waveformsWriteTimer.remainingTime() <= 0) {
+		waveformsWriteTimeout();
+	}
+}
+
+void Manager::writingWaveforms() {
+	_waveformsWriteTimer.stop();
+}
+
 void Manager::mapWriteTimeout() {
 	_writeMap(WriteMapWhen::Now);
 }
@@ -5262,6 +5553,10 @@ void Manager::locationsWriteTimeout() {
 	_writeLocations(WriteMapWhen::Now);
 }
 
+void Manager::waveformsWriteTimeout() {
+	_writeWaveforms(WriteMapWhen::Now);
+}
+
 void Manager::finish() {
 	if (_mapWriteTimer.isActive()) {
 		mapWriteTimeout();
@@ -5269,6 +5564,9 @@ void Manager::finish() {
 	if (_locationsWriteTimer.isActive()) {
 		locationsWriteTimeout();
 	}
+	if (_waveformsWriteTimer.isActive()) {
+		waveformsWriteTimeout();
+	}
 }
 
 } // namespace internal
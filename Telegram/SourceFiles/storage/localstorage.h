@@ -130,6 +130,7 @@ qint64 storageWebFilesSize();
 
 void countVoiceWaveform(DocumentData *document);
 
+void prioritizeTask(TaskId id);
 void cancelTask(TaskId id);
 
 void writeInstalledStickers();
@@ -195,15 +196,19 @@ public:
 	void writingMap();
 	void writeLocations(bool fast);
 	void writingLocations();
+	void writeWaveforms(bool fast);
+	void writingWaveforms();
 	void finish();
 
 public slots:
 	void mapWriteTimeout();
 	void locationsWriteTimeout();
+	void waveformsWriteTimeout();
 
 private:
 	QTimer _mapWriteTimer;
 	QTimer _locationsWriteTimer;
+	QTimer _waveformsWriteTimer;
 
 };
 
@@ -11,18 +11,13 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 namespace Storage {
 
-std::map<PeerId, SharedMedia::Lists>::iterator
-		SharedMedia::enforceLists(PeerId peer) {
-	auto result = _lists.find(peer);
-	if (result != _lists.end()) {
-		return result;
-	}
-	result = _lists.emplace(peer, Lists {}).first;
-	for (auto index = 0; index != kSharedMediaTypeCount; ++index) {
-		auto &list = result->second[index];
-		auto type = static_cast<SharedMediaType>(index);
+SparseIdsList &SharedMedia::enforceList(PeerId peer, Type type) {
+	Expects(IsValidSharedMediaType(type));
 
-		list.sliceUpdated(
+	auto &list = _lists[peer][static_cast<int>(type)];
+	if (!list) {
+		list = std::make_unique<SparseIdsList>();
+		list->sliceUpdated(
 		) | rpl::map([=](const SparseIdsSliceUpdate &update) {
 			return SharedMediaSliceUpdate(
 				peer,
@@ -30,26 +25,25 @@ std::map<PeerId, SharedMedia::Lists>::iterator
 				update);
 		}) | rpl::start_to_stream(_sliceUpdated, _lifetime);
 	}
-	return result;
+	return *list;
 }
 
 void SharedMedia::add(SharedMediaAddNew &&query) {
-	auto peer = query.peerId;
-	auto peerIt = enforceLists(peer);
 	for (auto index = 0; index != kSharedMediaTypeCount; ++index) {
 		auto type = static_cast<SharedMediaType>(index);
 		if (query.types.test(type)) {
-			peerIt->second[index].addNew(query.messageId);
+			enforceList(query.peerId, type).addNew(query.messageId);
 		}
 	}
 }
 
 void SharedMedia::add(SharedMediaAddExisting &&query) {
-	auto peerIt = enforceLists(query.peerId);
 	for (auto index = 0; index != kSharedMediaTypeCount; ++index) {
 		auto type = static_cast<SharedMediaType>(index);
 		if (query.types.test(type)) {
-			peerIt->second[index].addExisting(query.messageId, query.noSkipRange);
+			enforceList(query.peerId, type).addExisting(
+				query.messageId,
+				query.noSkipRange);
 		}
 	}
 }
@@ -57,9 +51,7 @@ void SharedMedia::add(SharedMediaAddExisting &&query) {
 void SharedMedia::add(SharedMediaAddSlice &&query) {
 	Expects(IsValidSharedMediaType(query.type));
 
-	auto peerIt = enforceLists(query.peerId);
-	auto index = static_cast<int>(query.type);
-	peerIt->second[index].addSlice(
+	enforceList(query.peerId, query.type).addSlice(
 		std::move(query.messageIds),
 		query.noSkipRange,
 		query.count);
@@ -70,8 +62,9 @@ void SharedMedia::remove(SharedMediaRemoveOne &&query) {
 	if (peerIt != _lists.end()) {
 		for (auto index = 0; index != kSharedMediaTypeCount; ++index) {
 			auto type = static_cast<SharedMediaType>(index);
-			if (query.types.test(type)) {
-				peerIt->second[index].removeOne(query.messageId);
+			const auto &list = peerIt->second[index];
+			if (list && query.types.test(type)) {
+				list->removeOne(query.messageId);
 			}
 		}
 		_oneRemoved.fire(std::move(query));
@@ -81,8 +74,10 @@ void SharedMedia::remove(SharedMediaRemoveOne &&query) {
 void SharedMedia::remove(SharedMediaRemoveAll &&query) {
 	auto peerIt = _lists.find(query.peerId);
 	if (peerIt != _lists.end()) {
+		// All the types become known to be empty.
 		for (auto index = 0; index != kSharedMediaTypeCount; ++index) {
-			peerIt->second[index].removeAll();
+			auto type = static_cast<SharedMediaType>(index);
+			enforceList(query.peerId, type).removeAll();
 		}
 		_allRemoved.fire(std::move(query));
 	}
@@ -91,8 +86,10 @@ void SharedMedia::remove(SharedMediaRemoveAll &&query) {
 void SharedMedia::invalidate(SharedMediaInvalidateBottom &&query) {
 	auto peerIt = _lists.find(query.peerId);
 	if (peerIt != _lists.end()) {
-		for (auto index = 0; index != kSharedMediaTypeCount; ++index) {
-			peerIt->second[index].invalidateBottom();
+		for (const auto &list : peerIt->second) {
+			if (list) {
+				list->invalidateBottom();
+			}
 		}
 		_bottomInvalidated.fire(std::move(query));
 	}
@@ -103,10 +100,12 @@ rpl::producer<SharedMediaResult> SharedMedia::query(SharedMediaQuery &&query) co
 	auto peerIt = _lists.find(query.key.peerId);
 	if (peerIt != _lists.end()) {
 		auto index = static_cast<int>(query.key.type);
-		return peerIt->second[index].query(SparseIdsListQuery(
-			query.key.messageId,
-			query.limitBefore,
-			query.limitAfter));
+		if (const auto &list = peerIt->second[index]) {
+			return list->query(SparseIdsListQuery(
+				query.key.messageId,
+				query.limitBefore,
+				query.limitAfter));
+		}
 	}
 	return [](auto consumer) {
 		consumer.put_done();
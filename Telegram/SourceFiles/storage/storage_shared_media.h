@@ -197,9 +197,13 @@ public:
 	rpl::producer<SharedMediaInvalidateBottom> bottomInvalidated() const;
 
 private:
-	using Lists = std::array<SparseIdsList, kSharedMediaTypeCount>;
+	// Lists are created only for the types that have some data,
+	// most peers get only a couple of them from new messages.
+	using Lists = std::array<
+		std::unique_ptr<SparseIdsList>,
+		kSharedMediaTypeCount>;
 
-	std::map<PeerId, Lists>::iterator enforceLists(PeerId peer);
+	SparseIdsList &enforceList(PeerId peer, Type type);
 
 	std::map<PeerId, Lists> _lists;
 
@@ -8,9 +8,92 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "ui/empty_userpic.h"
 
 #include "data/data_peer.h"
+#include "data/data_abstract_structure.h"
 #include "styles/style_history.h"
 
 namespace Ui {
+namespace {
+
+// Placeholders are shared between all peers with the same initials,
+// so the list of members of a large group is painted by blitting.
+constexpr auto kCachedPixmapsLimit = 256;
+
+struct CacheKey {
+	uint32 bg = 0;
+	uint32 fg = 0;
+	QString string;
+	int size = 0;
+	int shape = 0;
+	int ratio = 0;
+
+	inline bool operator<(const CacheKey &other) const {
+		return std::tie(bg, fg, size, shape, ratio, string)
+			< std::tie(
+				other.bg,
+				other.fg,
+				other.size,
+				other.shape,
+				other.ratio,
+				other.string);
+	}
+};
+
+struct CacheEntry {
+	QPixmap pixmap;
+	uint64 used = 0;
+};
+
+class CacheData : public Data::AbstractStructure {
+public:
+	const QPixmap *find(const CacheKey &key);
+	void remember(CacheKey &&key, QPixmap pixmap);
+
+private:
+	void evict();
+
+	base::flat_map<CacheKey, CacheEntry> _entries;
+	uint64 _counter = 0;
+
+};
+Data::GlobalStructurePointer<CacheData> PixmapCache;
+
+const QPixmap *CacheData::find(const CacheKey &key) {
+	const auto i = _entries.find(key);
+	if (i == _entries.end()) {
+		return nullptr;
+	}
+	i->second.used = ++_counter;
+	return &i->second.pixmap;
+}
+
+void CacheData::remember(CacheKey &&key, QPixmap pixmap) {
+	if (_entries.size() >= kCachedPixmapsLimit) {
+		evict();
+	}
+	_entries.emplace(std::move(key), CacheEntry{ pixmap, ++_counter });
+}
+
+void CacheData::evict() {
+	// Drop the least recently used half at once, so that
+	// the full scan happens only once per many insertions.
+	auto used = std::vector<uint64>();
+	used.reserve(_entries.size());
+	for (const auto &[key, entry] : _entries) {
+		used.push_back(entry.used);
+	}
+	const auto middle = begin(used) + used.size() / 2;
+	std::nth_element(begin(used), middle, end(used));
+	const auto border = *middle;
+	for (auto i = _entries.begin(); i != _entries.end();) {
+		if (i->second.used < border) {
+			i = _entries.erase(i);
+		} else {
+			++i;
+		}
+	}
+}
+
+} // namespace
 
 EmptyUserpic::EmptyUserpic(const style::color &color, const QString &name)
 : _color(color) {
@@ -48,21 +131,68 @@ void EmptyUserpic::paint(
 		int y,
 		int outerWidth,
 		int size) const {
-	paint(p, x, y, outerWidth, size, [&p, x, y, size] {
-		p.drawEllipse(x, y, size, size);
-	});
+	paintCached(p, x, y, outerWidth, size, Shape::Ellipse);
 }
 
 void EmptyUserpic::paintRounded(Painter &p, int x, int y, int outerWidth, int size) const {
-	paint(p, x, y, outerWidth, size, [&p, x, y, size] {
-		p.drawRoundedRect(x, y, size, size, st::buttonRadius, st::buttonRadius);
-	});
+	paintCached(p, x, y, outerWidth, size, Shape::Rounded);
 }
 
 void EmptyUserpic::paintSquare(Painter &p, int x, int y, int outerWidth, int size) const {
-	paint(p, x, y, outerWidth, size, [&p, x, y, size] {
-		p.fillRect(x, y, size, size, p.brush());
-	});
+	paintCached(p, x, y, outerWidth, size, Shape::Square);
+}
+
+void EmptyUserpic::paintCached(
+		Painter &p,
+		int x,
+		int y,
+		int outerWidth,
+		int size,
+		Shape shape) const {
+	x = rtl() ? (outerWidth - x - size) : x;
+
+	PixmapCache.createIfNull();
+	auto key = CacheKey();
+	key.bg = _color->c.rgba();
+	key.fg = st::historyPeerUserpicFg->c.rgba();
+	key.string = _string;
+	key.size = size;
+	key.shape = static_cast<int>(shape);
+	key.ratio = cIntRetinaFactor();
+	if (const auto pixmap = PixmapCache->find(key)) {
+		p.drawPixmap(x, y, *pixmap);
+		return;
+	}
+	auto pixmap = prepare(size, shape);
+	p.drawPixmap(x, y, pixmap);
+	PixmapCache->remember(std::move(key), std::move(pixmap));
+}
+
+QPixmap EmptyUserpic::prepare(int size, Shape shape) const {
+	auto result = QImage(QSize(size, size) * cIntRetinaFactor(), QImage::Format_ARGB32_Premultiplied);
+	result.setDevicePixelRatio(cRetinaFactor());
+	result.fill(Qt::transparent);
+	{
+		Painter p(&result);
+		switch (shape) {
+		case Shape::Ellipse:
+			paint(p, 0, 0, size, size, [&p, size] {
+				p.drawEllipse(0, 0, size, size);
+			});
+			break;
+		case Shape::Rounded:
+			paint(p, 0, 0, size, size, [&p, size] {
+				p.drawRoundedRect(0, 0, size, size, st::buttonRadius, st::buttonRadius);
+			});
+			break;
+		case Shape::Square:
+			paint(p, 0, 0, size, size, [&p, size] {
+				p.fillRect(0, 0, size, size, p.brush());
+			});
+			break;
+		}
+	}
+	return App::pixmapFromImageInPlace(std::move(result));
 }
 
 void EmptyUserpic::PaintSavedMessages(
@@ -167,14 +297,7 @@ StorageKey EmptyUserpic::uniqueKey() const {
 }
 
 QPixmap EmptyUserpic::generate(int size) {
-	auto result = QImage(QSize(size, size) * cIntRetinaFactor(), QImage::Format_ARGB32_Premultiplied);
-	result.setDevicePixelRatio(cRetinaFactor());
-	result.fill(Qt::transparent);
-	{
-		Painter p(&result);
-		paint(p, 0, 0, size, size);
-	}
-	return App::pixmapFromImageInPlace(std::move(result));
+	return prepare(size, Shape::Ellipse);
 }
 
 void EmptyUserpic::fillString(const QString &name) {
@@ -52,6 +52,21 @@ public:
 	~EmptyUserpic();
 
 private:
+	enum class Shape {
+		Ellipse,
+		Rounded,
+		Square,
+	};
+
+	void paintCached(
+		Painter &p,
+		int x,
+		int y,
+		int outerWidth,
+		int size,
+		Shape shape) const;
+	QPixmap prepare(int size, Shape shape) const;
+
 	template <typename Callback>
 	void paint(
 		Painter &p,
@@ -14,6 +14,11 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "history/history_item.h"
 #include "history/history.h"
 
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#define IMAGES_BLUR_SSE2
+#include <emmintrin.h>
+#endif // __SSE2__ || _M_X64 || _M_IX86_FP >= 2
+
 namespace Images {
 namespace {
 
@@ -21,6 +26,80 @@ FORCE_INLINE uint64 blurGetColors(const uchar *p) {
 	return (uint64)p[0] + ((uint64)p[1] << 16) + ((uint64)p[2] << 32) + ((uint64)p[3] << 48);
 }
 
+// One row of the vertical blur pass for all the columns at once.
+// Each of the sums holds four 16 bit channels, the same way
+// blurGetColors() packs them, so the integer math is lane-exact.
+void blurVerticalRowScalar(
+		uint64 *sums,
+		uint64 *allsums,
+		const uint64 *start,
+		const uint64 *middle,
+		const uint64 *end,
+		uchar *to,
+		int from,
+		int till) {
+	for (auto x = from; x != till; ++x) {
+		const auto res = sums[x] >> 4;
+		to[x * 4] = res & 0xFF;
+		to[x * 4 + 1] = (res >> 16) & 0xFF;
+		to[x * 4 + 2] = (res >> 32) & 0xFF;
+		to[x * 4 + 3] = (res >> 48) & 0xFF;
+		allsums[x] += start[x] - 2 * middle[x] + end[x];
+		sums[x] += allsums[x];
+	}
+}
+
+#ifdef IMAGES_BLUR_SSE2
+
+void blurVerticalRowSSE2(
+		uint64 *sums,
+		uint64 *allsums,
+		const uint64 *start,
+		const uint64 *middle,
+		const uint64 *end,
+		uchar *to,
+		int width) {
+	const auto mask = _mm_set1_epi64x(0x00FF00FF00FF00FFLL);
+	const auto zero = _mm_setzero_si128();
+	auto x = 0;
+	for (; x + 2 <= width; x += 2) {
+		const auto sum = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + x));
+		const auto res = _mm_and_si128(_mm_srli_epi64(sum, 4), mask);
+		_mm_storel_epi64(
+			reinterpret_cast<__m128i*>(to + x * 4),
+			_mm_packus_epi16(res, zero));
+
+		const auto s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(start + x));
+		const auto m = _mm_loadu_si128(reinterpret_cast<const __m128i*>(middle + x));
+		const auto e = _mm_loadu_si128(reinterpret_cast<const __m128i*>(end + x));
+		const auto all = _mm_add_epi64(
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(allsums + x)),
+			_mm_sub_epi64(_mm_add_epi64(s, e), _mm_add_epi64(m, m)));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(allsums + x), all);
+		_mm_storeu_si128(
+			reinterpret_cast<__m128i*>(sums + x),
+			_mm_add_epi64(sum, all));
+	}
+	blurVerticalRowScalar(sums, allsums, start, middle, end, to, x, width);
+}
+
+#endif // IMAGES_BLUR_SSE2
+
+void blurVerticalRow(
+		uint64 *sums,
+		uint64 *allsums,
+		const uint64 *start,
+		const uint64 *middle,
+		const uint64 *end,
+		uchar *to,
+		int width) {
+#ifdef IMAGES_BLUR_SSE2
+	blurVerticalRowSSE2(sums, allsums, start, middle, end, to, width);
+#else // IMAGES_BLUR_SSE2
+	blurVerticalRowScalar(sums, allsums, start, middle, end, to, 0, width);
+#endif // IMAGES_BLUR_SSE2
+}
+
 const QPixmap &circleMask(int width, int height) {
 	Assert(Global::started());
 
@@ -132,40 +211,30 @@ x++;
 				yw += stride;
 			}
 
+			// Columns are independent, so the vertical pass walks the rows
+			// once and updates the sums of all the columns together.
 			const int he = h - r1;
+			auto sums = std::vector<uint64>(w);
+			auto allsums = std::vector<uint64>(w);
 			for (x = 0; x < w; x++) {
-				uint64 rgballsum = -radius * rgb[x];
-				uint64 rgbsum = rgb[x] * ((r1 * (r1 + 1)) >> 1);
+				allsums[x] = -radius * rgb[x];
+				sums[x] = rgb[x] * ((r1 * (r1 + 1)) >> 1);
 				for (i = 1; i <= radius; i++) {
-					rgbsum += rgb[i * w + x] * (r1 - i);
-					rgballsum += rgb[i * w + x];
+					sums[x] += rgb[i * w + x] * (r1 - i);
+					allsums[x] += rgb[i * w + x];
 				}
-
-				y = 0;
-				int yi = x * 4;
-
-#define update(start, middle, end) \
-uint64 res = rgbsum >> 4; \
-pix[yi] = res & 0xFF; \
-pix[yi + 1] = (res >> 16) & 0xFF; \
-pix[yi + 2] = (res >> 32) & 0xFF; \
-pix[yi + 3] = (res >> 48) & 0xFF; \
-rgballsum += rgb[x + (start) * w] - 2 * rgb[x + (middle) * w] + rgb[x + (end) * w]; \
-rgbsum += rgballsum; \
-y++; \
-yi += stride;
-
-				while (y < r1) {
-					update(0, y, y + r1);
-				}
-				while (y < he) {
-					update(y - r1, y, y + r1);
-				}
-				while (y < h) {
-					update(y - r1, y, h - 1);
-				}
-
-#undef update
+			}
+			for (y = 0; y < h; y++) {
+				const auto start = (y < r1) ? 0 : (y - r1);
+				const auto end = (y < he) ? (y + r1) : (h - 1);
+				blurVerticalRow(
+					sums.data(),
+					allsums.data(),
+					rgb + start * w,
+					rgb + y * w,
+					rgb + end * w,
+					pix + y * stride,
+					w);
 			}
 
 			delete[] rgb;
@@ -303,7 +372,24 @@ QImage prepareOpaque(QImage image) {
 	return image;
 }
 
-QImage prepare(QImage img, int w, int h, Images::Options options, int outerw, int outerh, const style::color *colored) {
+PrepareStyle PrepareStyleFor(Options options) {
+	auto result = PrepareStyle();
+	result.background = st::imageBg->c;
+	const auto radius = (options & Images::Option::RoundedLarge)
+		? ImageRoundRadius::Large
+		: (options & Images::Option::RoundedSmall)
+		? ImageRoundRadius::Small
+		: ImageRoundRadius::None;
+	if (radius != ImageRoundRadius::None) {
+		const auto masks = App::cornersMask(radius);
+		for (auto i = 0; i != 4; ++i) {
+			result.corners[i] = masks[i];
+		}
+	}
+	return result;
+}
+
+QImage prepare(QImage img, int w, int h, Images::Options options, int outerw, int outerh, const PrepareStyle &style) {
 	Assert(!img.isNull());
 	if (options & Images::Option::Blurred) {
 		img = prepareBlur(std::move(img));
@@ -330,7 +416,7 @@ QImage prepare(QImage img, int w, int h, Images::Options options, int outerw, in
 			{
 				QPainter p(&result);
 				if (w < outerw || h < outerh) {
-					p.fillRect(0, 0, result.width(), result.height(), st::imageBg);
+					p.fillRect(0, 0, result.width(), result.height(), style.background);
 				}
 				p.drawImage((result.width() - img.width()) / (2 * cIntRetinaFactor()), (result.height() - img.height()) / (2 * cIntRetinaFactor()), img);
 			}
@@ -338,27 +424,37 @@ QImage prepare(QImage img, int w, int h, Images::Options options, int outerw, in
 			Assert(!img.isNull());
 		}
 	}
-	auto corners = [](Images::Options options) {
-		return ((options & Images::Option::RoundedTopLeft) ? RectPart::TopLeft : RectPart::None)
-			| ((options & Images::Option::RoundedTopRight) ? RectPart::TopRight : RectPart::None)
-			| ((options & Images::Option::RoundedBottomLeft) ? RectPart::BottomLeft : RectPart::None)
-			| ((options & Images::Option::RoundedBottomRight) ? RectPart::BottomRight : RectPart::None);
-	};
+	const auto corners = ((options & Images::Option::RoundedTopLeft) ? RectPart::TopLeft : RectPart::None)
+		| ((options & Images::Option::RoundedTopRight) ? RectPart::TopRight : RectPart::None)
+		| ((options & Images::Option::RoundedBottomLeft) ? RectPart::BottomLeft : RectPart::None)
+		| ((options & Images::Option::RoundedBottomRight) ? RectPart::BottomRight : RectPart::None);
 	if (options & Images::Option::Circled) {
 		prepareCircle(img);
 		Assert(!img.isNull());
-	} else if (options & Images::Option::RoundedLarge) {
-		prepareRound(img, ImageRoundRadius::Large, corners(options));
-		Assert(!img.isNull());
-	} else if (options & Images::Option::RoundedSmall) {
-		prepareRound(img, ImageRoundRadius::Small, corners(options));
+	} else if ((options & (Images::Option::RoundedLarge | Images::Option::RoundedSmall))
+		&& static_cast<int>(corners)) {
+		img.setDevicePixelRatio(cRetinaFactor());
+		img = std::move(img).convertToFormat(QImage::Format_ARGB32_Premultiplied);
 		Assert(!img.isNull());
+		QImage masks[] = {
+			style.corners[0],
+			style.corners[1],
+			style.corners[2],
+			style.corners[3],
+		};
+		prepareRound(img, masks, corners);
 	}
+	img.setDevicePixelRatio(cRetinaFactor());
+	return img;
+}
+
+QImage prepare(QImage img, int w, int h, Images::Options options, int outerw, int outerh, const style::color *colored) {
+	img = prepare(std::move(img), w, h, options, outerw, outerh, PrepareStyleFor(options));
 	if (options & Images::Option::Colored) {
 		Assert(colored != nullptr);
 		img = prepareColored(*colored, std::move(img));
+		img.setDevicePixelRatio(cRetinaFactor());
 	}
-	img.setDevicePixelRatio(cRetinaFactor());
 	return img;
 }
 
@@ -400,6 +496,30 @@ uint64 SinglePixKey(Images::Options options) {
 	return PixKey(0, 0, options);
 }
 
+Images::Options SinglePixOptions(
+		ImageRoundRadius radius,
+		RectParts corners,
+		const style::color *colored) {
+	auto options = Images::Option::Smooth | Images::Option::None;
+	auto cornerOptions = [](RectParts corners) {
+		return (corners & RectPart::TopLeft ? Images::Option::RoundedTopLeft : Images::Option::None)
+			| (corners & RectPart::TopRight ? Images::Option::RoundedTopRight : Images::Option::None)
+			| (corners & RectPart::BottomLeft ? Images::Option::RoundedBottomLeft : Images::Option::None)
+			| (corners & RectPart::BottomRight ? Images::Option::RoundedBottomRight : Images::Option::None);
+	};
+	if (radius == ImageRoundRadius::Large) {
+		options |= Images::Option::RoundedLarge | cornerOptions(corners);
+	} else if (radius == ImageRoundRadius::Small) {
+		options |= Images::Option::RoundedSmall | cornerOptions(corners);
+	} else if (radius == ImageRoundRadius::Ellipse) {
+		options |= Images::Option::Circled | cornerOptions(corners);
+	}
+	if (colored) {
+		options |= Images::Option::Colored;
+	}
+	return options;
+}
+
 } // namespace
 
 StorageImageLocation StorageImageLocation::Null;
@@ -632,24 +752,7 @@ const QPixmap &Image::pixSingle(int32 w, int32 h, int32 outerw, int32 outerh, Im
 		h *= cIntRetinaFactor();
 	}
 
-	auto options = Images::Option::Smooth | Images::Option::None;
-	auto cornerOptions = [](RectParts corners) {
-		return (corners & RectPart::TopLeft ? Images::Option::RoundedTopLeft : Images::Option::None)
-			| (corners & RectPart::TopRight ? Images::Option::RoundedTopRight : Images::Option::None)
-			| (corners & RectPart::BottomLeft ? Images::Option::RoundedBottomLeft : Images::Option::None)
-			| (corners & RectPart::BottomRight ? Images::Option::RoundedBottomRight : Images::Option::None);
-	};
-	if (radius == ImageRoundRadius::Large) {
-		options |= Images::Option::RoundedLarge | cornerOptions(corners);
-	} else if (radius == ImageRoundRadius::Small) {
-		options |= Images::Option::RoundedSmall | cornerOptions(corners);
-	} else if (radius == ImageRoundRadius::Ellipse) {
-		options |= Images::Option::Circled | cornerOptions(corners);
-	}
-	if (colored) {
-		options |= Images::Option::Colored;
-	}
-
+	auto options = SinglePixOptions(radius, corners, colored);
 	auto k = SinglePixKey(options);
 	auto i = _sizesCache.constFind(k);
 	if (i == _sizesCache.cend() || i->width() != (outerw * cIntRetinaFactor()) || i->height() != (outerh * cIntRetinaFactor())) {
@@ -666,6 +769,97 @@ const QPixmap &Image::pixSingle(int32 w, int32 h, int32 outerw, int32 outerh, Im
 	return i.value();
 }
 
+bool Image::pixSingleReady(int32 w, int32 h, int32 outerw, int32 outerh, ImageRoundRadius radius, RectParts corners) const {
+	checkload();
+
+	if (!loaded() || (_data.isNull() && !_forgot) || radius == ImageRoundRadius::Ellipse) {
+		// Blank images are cheap and circle masks are cached
+		// on the main thread, so prepare those synchronously.
+		return true;
+	}
+	if (w <= 0 || !width() || !height()) {
+		w = width() * cIntRetinaFactor();
+	} else if (cRetina()) {
+		w *= cIntRetinaFactor();
+		h *= cIntRetinaFactor();
+	}
+
+	const auto options = SinglePixOptions(radius, corners, nullptr);
+	const auto k = SinglePixKey(options);
+	const auto size = QSize(outerw, outerh) * cIntRetinaFactor();
+	const auto i = _sizesCache.constFind(k);
+	if (i != _sizesCache.cend() && i->size() == size) {
+		return true;
+	}
+	if (_preparingSingle.contains(k)) {
+		// One preparation per key at a time. When it is done the view
+		// repaints and asks again for the size it needs by then.
+		return false;
+	}
+	static auto LastPreparingId = 0;
+	const auto id = ++LastPreparingId;
+	_preparingSingle.emplace(k, id);
+
+	auto original = _forgot ? QImage() : _data.toImage();
+	auto saved = _forgot ? _saved : QByteArray();
+	auto format = _format;
+	auto style = Images::PrepareStyleFor(options);
+	const auto weak = base::make_weak(const_cast<Image*>(this));
+	crl::async([=, original = std::move(original)]() mutable {
+		const auto started = getms(true);
+		if (original.isNull()) {
+			QBuffer buffer(&saved);
+			QImageReader reader(&buffer, format);
+#ifndef OS_MAC_OLD
+			reader.setAutoTransform(true);
+#endif // OS_MAC_OLD
+			original = reader.read();
+		}
+		const auto decoded = getms(true);
+		auto result = original.isNull()
+			? QImage()
+			: Images::prepare(std::move(original), w, h, options, outerw, outerh, style);
+		const auto prepared = getms(true);
+		DEBUG_LOG(("Images Info: single %1x%2 decode %3ms, prepare %4ms."
+			).arg(size.width()
+			).arg(size.height()
+			).arg(decoded - started
+			).arg(prepared - decoded));
+		crl::on_main(weak, [=, result = std::move(result)]() mutable {
+			const auto j = _preparingSingle.find(k);
+			if (j == _preparingSingle.end() || j->second != id) {
+				return;
+			}
+			_preparingSingle.erase(j);
+			singlePrepared(k, std::move(result));
+		});
+	});
+	return false;
+}
+
+const QPixmap *Image::pixSingleLast(ImageRoundRadius radius, RectParts corners) const {
+	const auto options = SinglePixOptions(radius, corners, nullptr);
+	const auto i = _sizesCache.constFind(SinglePixKey(options));
+	return (i != _sizesCache.cend() && !i->isNull()) ? &i.value() : nullptr;
+}
+
+void Image::singlePrepared(uint64 key, QImage &&image) const {
+	if (image.isNull()) {
+		return;
+	}
+	auto i = _sizesCache.find(key);
+	if (i != _sizesCache.end()) {
+		globalAcquiredSize -= int64(i->width()) * i->height() * 4;
+	}
+	auto p = App::pixmapFromImageInPlace(std::move(image));
+	if (cRetina()) p.setDevicePixelRatio(cRetinaFactor());
+	_sizesCache.insert(key, p);
+	globalAcquiredSize += int64(p.width()) * p.height() * 4;
+	if (AuthSession::Exists()) {
+		Auth().downloaderTaskFinished().notify();
+	}
+}
+
 const QPixmap &Image::pixBlurredSingle(int w, int h, int32 outerw, int32 outerh, ImageRoundRadius radius, RectParts corners) const {
 	checkload();
 
@@ -831,6 +1025,7 @@ void Image::restore() const {
 }
 
 void Image::invalidateSizeCache() const {
+	_preparingSingle.clear();
 	for (auto &pix : _sizesCache) {
 		if (!pix.isNull()) {
 			globalAcquiredSize -= int64(pix.width()) * pix.height() * 4;
@@ -1002,6 +1197,12 @@ void RemoteImage::cancel() {
 	Auth().downloader().delayedDestroyLoader(std::unique_ptr<FileLoader>(loader));
 }
 
+void RemoteImage::stopLoading() {
+	if (!amLoading()) return;
+
+	destroyLoaderDelayed();
+}
+
 float64 RemoteImage::progress() const {
 	return amLoading() ? _loader->currentProgress() : (loaded() ? 1 : 0);
 }
@@ -1176,6 +1377,11 @@ void DelayedStorageImage::cancel() {
 	StorageImage::cancel();
 }
 
+void DelayedStorageImage::stopLoading() {
+	_loadRequested = false;
+	StorageImage::stopLoading();
+}
+
 WebImage::WebImage(const QString &url, QSize box)
 : _url(url)
 , _box(box)
@@ -57,6 +57,15 @@ enum class Option {
 using Options = base::flags<Option>;
 inline constexpr auto is_flag_type(Option) { return true; };
 
+// What prepare() reads from the style, captured on the main thread
+// so that images without Colored option can be prepared on any thread.
+struct PrepareStyle {
+	QColor background;
+	QImage corners[4];
+};
+PrepareStyle PrepareStyleFor(Options options);
+
+QImage prepare(QImage img, int w, int h, Options options, int outerw, int outerh, const PrepareStyle &style);
 QImage prepare(QImage img, int w, int h, Options options, int outerw, int outerh, const style::color *colored = nullptr);
 
 inline QPixmap pixmap(QImage img, int w, int h, Options options, int outerw, int outerh, const style::color *colored = nullptr) {
@@ -224,7 +233,7 @@ inline bool operator!=(const WebFileLocation &a, const WebFileLocation &b) {
 class DelayedStorageImage;
 
 class HistoryItem;
-class Image {
+class Image : public base::has_weak_ptr {
 public:
 	Image(const QString &file, QByteArray format = QByteArray());
 	Image(const QByteArray &filecontent, QByteArray format = QByteArray());
@@ -247,6 +256,9 @@ public:
 	}
 	virtual void cancel() {
 	}
+	// Unlike cancel() this allows the automatic loading to start again.
+	virtual void stopLoading() {
+	}
 	virtual float64 progress() const {
 		return 1;
 	}
@@ -260,6 +272,12 @@ public:
 	const QPixmap &pixColored(style::color add, int32 w = 0, int32 h = 0) const;
 	const QPixmap &pixBlurredColored(style::color add, int32 w = 0, int32 h = 0) const;
 	const QPixmap &pixSingle(int32 w, int32 h, int32 outerw, int32 outerh, ImageRoundRadius radius, RectParts corners = RectPart::AllCorners, const style::color *colored = nullptr) const;
+
+	// Prepares the pixSingle() result in the background, returns true
+	// when it can be painted without any work on the main thread.
+	bool pixSingleReady(int32 w, int32 h, int32 outerw, int32 outerh, ImageRoundRadius radius, RectParts corners = RectPart::AllCorners) const;
+	// The last prepared pixSingle() result of any size, may be nullptr.
+	const QPixmap *pixSingleLast(ImageRoundRadius radius, RectParts corners = RectPart::AllCorners) const;
 	const QPixmap &pixBlurredSingle(int32 w, int32 h, int32 outerw, int32 outerh, ImageRoundRadius radius, RectParts corners = RectPart::AllCorners) const;
 	const QPixmap &pixCircled(int32 w = 0, int32 h = 0) const;
 	const QPixmap &pixBlurredCircled(int32 w = 0, int32 h = 0) const;
@@ -333,8 +351,11 @@ protected:
 	mutable QPixmap _data;
 
 private:
+	void singlePrepared(uint64 key, QImage &&image) const;
+
 	using Sizes = QMap<uint64, QPixmap>;
 	mutable Sizes _sizesCache;
+	mutable base::flat_map<uint64, int> _preparingSingle;
 
 };
 
@@ -371,6 +392,7 @@ public:
 	}
 	bool displayLoading() const;
 	void cancel();
+	void stopLoading();
 	float64 progress() const;
 	int32 loadOffset() const;
 
@@ -477,6 +499,7 @@ public:
 	}
 	bool displayLoading() const;
 	void cancel();
+	void stopLoading();
 
 	void load(bool loadFirst = false, bool prior = true);
 	void loadEvenCancelled(bool loadFirst = false, bool prior = true);
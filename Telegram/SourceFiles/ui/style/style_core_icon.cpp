@@ -15,9 +15,11 @@ uint32 colorKey(QColor c) {
 	return (((((uint32(c.red()) << 8) | uint32(c.green())) << 8) | uint32(c.blue())) << 8) | uint32(c.alpha());
 }
 
+using IconAtlases = QMap<QPair<const IconAtlas*, int>, QImage>;
 using IconMasks = QMap<const IconMask*, QImage>;
 using IconPixmaps = QMap<QPair<const IconMask*, uint32>, QPixmap>;
 using IconDatas = OrderedSet<IconData*>;
+NeverFreedPointer<IconAtlases> iconAtlases;
 NeverFreedPointer<IconMasks> iconMasks;
 NeverFreedPointer<IconPixmaps> iconPixmaps;
 NeverFreedPointer<IconDatas> iconData;
@@ -29,33 +31,41 @@ inline int pxAdjust(int value, int scale) {
 	return qFloor((value * scale / 4.) + 0.1);
 }
 
-QImage createIconMask(const IconMask *mask, DBIScale scale) {
-	auto maskImage = QImage::fromData(mask->data(), mask->size(), "PNG");
-	maskImage.setDevicePixelRatio(cRetinaFactor());
-	Assert(!maskImage.isNull());
-
-	// images are layouted like this:
-	// 200x 100x
-	// 150x 125x
-	int width = maskImage.width() / 3;
-	int height = qRound((maskImage.height() * 2) / 7.);
-	auto r = QRect(0, 0, width * 2, height * 2);
-	if (!cRetina() && scale != dbisTwo) {
-		if (scale == dbisOne) {
-			r = QRect(width * 2, 0, width, height);
-		} else {
-			int width125 = pxAdjust(width, 5);
-			int height125 = pxAdjust(height, 5);
-			int width150 = pxAdjust(width, 6);
-			int height150 = pxAdjust(height, 6);
-			if (scale == dbisOneAndQuarter) {
-				r = QRect(width150, height * 2, width125, height125);
-			} else {
-				r = QRect(0, height * 2, width150, height150);
-			}
-		}
+int atlasIndex(DBIScale scale) {
+	if (cRetina()) {
+		return 3;
+	}
+	switch (scale) {
+	case dbisOne: return 0;
+	case dbisOneAndQuarter: return 1;
+	case dbisTwo: return 3;
+	}
+	return 2;
+}
+
+const QImage &atlasImage(const IconAtlas *atlas, int index) {
+	iconAtlases.createIfNull();
+	const auto key = qMakePair(atlas, index);
+	auto i = iconAtlases->constFind(key);
+	if (i == iconAtlases->cend()) {
+		auto image = QImage::fromData(
+			atlas->data(index),
+			atlas->size(index),
+			"PNG");
+		Assert(!image.isNull());
+		i = iconAtlases->insert(key, std::move(image));
 	}
-	return maskImage.copy(r);
+	return i.value();
+}
+
+QImage createIconMask(const IconMask *mask, DBIScale scale) {
+	Expects(mask->atlas() != nullptr);
+
+	// The atlas is decoded once for all the icons of the module.
+	const auto index = atlasIndex(scale);
+	auto result = atlasImage(mask->atlas(), index).copy(mask->rect(index));
+	result.setDevicePixelRatio(cRetinaFactor());
+	return result;
 }
 
 QSize readGeneratedSize(const IconMask *mask, DBIScale scale) {
@@ -353,6 +363,7 @@ void destroyIcons() {
 	iconData.clear();
 	iconPixmaps.clear();
 	iconMasks.clear();
+	iconAtlases.clear();
 }
 
 } // namespace internal
@@ -13,12 +13,49 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 namespace style {
 namespace internal {
 
+// PNG images with all the module icon masks packed, one for each scale.
+class IconAtlas {
+public:
+	template <int N100, int N125, int N150, int N200>
+	IconAtlas(
+		const uchar (&data100x)[N100],
+		const uchar (&data125x)[N125],
+		const uchar (&data150x)[N150],
+		const uchar (&data200x)[N200])
+	: _data{ data100x, data125x, data150x, data200x }
+	, _size{ N100, N125, N150, N200 } {
+	}
+
+	static constexpr auto kScalesCount = 4;
+
+	const uchar *data(int index) const {
+		return _data[index];
+	}
+	int size(int index) const {
+		return _size[index];
+	}
+
+private:
+	const uchar *_data[kScalesCount];
+	int _size[kScalesCount];
+
+};
+
 class IconMask {
 public:
 	template <int N>
 	IconMask(const uchar (&data)[N]) : _data(data), _size(N) {
 		static_assert(N > 0, "invalid image data");
 	}
+	IconMask(
+		const IconAtlas &atlas,
+		QRect rect100x,
+		QRect rect125x,
+		QRect rect150x,
+		QRect rect200x)
+	: _atlas(&atlas)
+	, _rects{ rect100x, rect125x, rect150x, rect200x } {
+	}
 
 	const uchar *data() const {
 		return _data;
@@ -26,10 +63,18 @@ public:
 	int size() const {
 		return _size;
 	}
+	const IconAtlas *atlas() const {
+		return _atlas;
+	}
+	QRect rect(int index) const {
+		return _rects[index];
+	}
 
 private:
-	const uchar *_data;
-	const int _size;
+	const uchar *_data = nullptr;
+	const int _size = 0;
+	const IconAtlas *_atlas = nullptr;
+	QRect _rects[IconAtlas::kScalesCount];
 
 };
 
@@ -1594,6 +1594,34 @@ void ParseEntities(TextWithEntities &result, int32 flags, bool rich) {
 	int32 len = result.text.size(), commandOffset = rich ? 0 : len;
 	bool inLink = false, commandIsLink = false;
 	const QChar *start = result.text.constData(), *end = start + result.text.size();
+
+	// A match found from some offset is also the first match from any
+	// later offset up to its start, so each expression is run again only
+	// after the scan passes its last match. The result is the same as
+	// matching all of them from every offset.
+	struct CachedMatch {
+		QRegularExpressionMatch match;
+		int from = -1;
+	};
+	auto domainCache = CachedMatch();
+	auto explicitDomainCache = CachedMatch();
+	auto hashtagCache = CachedMatch();
+	auto mentionCache = CachedMatch();
+	auto botCommandCache = CachedMatch();
+	const auto findMatch = [&](
+			CachedMatch &cached,
+			const QRegularExpression &expression,
+			int from) {
+		const auto reuse = (cached.from >= 0)
+			&& (from >= cached.from)
+			&& (!cached.match.hasMatch()
+				|| cached.match.capturedStart() >= from);
+		if (!reuse) {
+			cached.match = expression.match(result.text, from);
+			cached.from = from;
+		}
+		return cached.match;
+	};
 	for (int32 offset = 0, matchOffset = offset, mentionSkip = 0; offset < len;) {
 		if (commandOffset <= offset) {
 			for (commandOffset = offset; commandOffset < len; ++commandOffset) {
@@ -1604,11 +1632,11 @@ void ParseEntities(TextWithEntities &result, int32 flags, bool rich) {
 				}
 			}
 		}
-		auto mDomain = RegExpDomain().match(result.text, matchOffset);
-		auto mExplicitDomain = RegExpDomainExplicit().match(result.text, matchOffset);
-		auto mHashtag = withHashtags ? RegExpHashtag().match(result.text, matchOffset) : QRegularExpressionMatch();
-		auto mMention = withMentions ? RegExpMention().match(result.text, qMax(mentionSkip, matchOffset)) : QRegularExpressionMatch();
-		auto mBotCommand = withBotCommands ? RegExpBotCommand().match(result.text, matchOffset) : QRegularExpressionMatch();
+		auto mDomain = findMatch(domainCache, RegExpDomain(), matchOffset);
+		auto mExplicitDomain = findMatch(explicitDomainCache, RegExpDomainExplicit(), matchOffset);
+		auto mHashtag = withHashtags ? findMatch(hashtagCache, RegExpHashtag(), matchOffset) : QRegularExpressionMatch();
+		auto mMention = withMentions ? findMatch(mentionCache, RegExpMention(), qMax(mentionSkip, matchOffset)) : QRegularExpressionMatch();
+		auto mBotCommand = withBotCommands ? findMatch(botCommandCache, RegExpBotCommand(), matchOffset) : QRegularExpressionMatch();
 
 		EntityInTextType lnkType = EntityInTextUrl;
 		int32 lnkStart = 0, lnkLength = 0;
@@ -1648,7 +1676,7 @@ void ParseEntities(TextWithEntities &result, int32 flags, bool rich) {
 			}
 			if (!(start + mentionStart + 1)->isLetter() || !(start + mentionEnd - 1)->isLetterOrNumber()) {
 				mentionSkip = mentionEnd;
-				mMention = RegExpMention().match(result.text, qMax(mentionSkip, matchOffset));
+				mMention = findMatch(mentionCache, RegExpMention(), qMax(mentionSkip, matchOffset));
 				if (mMention.hasMatch()) {
 					mentionStart = mMention.capturedStart();
 					mentionEnd = mMention.capturedEnd();
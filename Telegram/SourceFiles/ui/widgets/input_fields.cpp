@@ -26,6 +26,7 @@ constexpr auto kInstantReplaceWhatId = QTextFormat::UserProperty + 1;
 constexpr auto kInstantReplaceWithId = QTextFormat::UserProperty + 2;
 constexpr auto kReplaceTagId = QTextFormat::UserProperty + 3;
 constexpr auto kTagProperty = QTextFormat::UserProperty + 4;
+constexpr auto kSlowContentsChange = TimeMs(16);
 const auto kObjectReplacementCh = QChar(QChar::ObjectReplacementCharacter);
 const auto kObjectReplacement = QString::fromRawData(
 	&kObjectReplacementCh,
@@ -702,6 +703,12 @@ struct FormattingAction {
 		ClearInstantReplace,
 	};
 
+	struct Emoji {
+		EmojiPtr emoji = nullptr;
+		int intervalStart = 0;
+		int intervalEnd = 0;
+	};
+
 	Type type = Type::Invalid;
 	EmojiPtr emoji = nullptr;
 	bool isTilde = false;
@@ -709,8 +716,79 @@ struct FormattingAction {
 	int intervalStart = 0;
 	int intervalEnd = 0;
 
+	// Emoji following the first one in the same fragment.
+	std::vector<Emoji> moreEmoji;
+
 };
 
+void CollectMoreEmoji(
+		FormattingAction &action,
+		bool singleLine,
+		int fragmentPosition,
+		const QChar *textStart,
+		const QChar *from,
+		const QChar *till,
+		int insertEnd,
+		bool breakTagOnNotLetter,
+		bool tildeFormatting,
+		bool isTildeFragment) {
+	// Find the emoji that would be replaced right after the first one,
+	// so that a pasted text with a lot of emoji doesn't restart the scan
+	// from the block start for each of them.
+	auto lastEnd = action.intervalEnd;
+	for (auto ch = from; ch < till && lastEnd < insertEnd;) {
+		auto emojiLength = 0;
+		if (singleLine && IsNewline(*ch)) {
+			break;
+		} else if (const auto emoji = Ui::Emoji::Find(ch, till, &emojiLength)) {
+			const auto start = fragmentPosition + int(ch - textStart);
+			lastEnd = start + emojiLength;
+			action.moreEmoji.push_back({ emoji, start, lastEnd });
+			ch += emojiLength;
+			continue;
+		} else if (breakTagOnNotLetter && !ch->isLetter()) {
+			break;
+		} else if (tildeFormatting
+			&& ((ch->unicode() == '~') != isTildeFragment)) {
+			break;
+		} else if (ch->isHighSurrogate()) {
+			break;
+		}
+		++ch;
+	}
+}
+
+void InsertEmoji(
+		not_null<QTextDocument*> document,
+		const FormattingAction &action,
+		QTextCursor cursor,
+		int &insertPosition,
+		int &insertEnd) {
+	// Positions in action are from the document before any replacement,
+	// so replace from the end and adjust the insert range as if the emoji
+	// were replaced one by one from the start.
+	const auto &more = action.moreEmoji;
+	for (auto i = more.rbegin(); i != more.rend(); ++i) {
+		auto moreCursor = QTextCursor(document->docHandle(), i->intervalStart);
+		moreCursor.setPosition(i->intervalEnd, QTextCursor::KeepAnchor);
+		InsertEmojiAtCursor(moreCursor, i->emoji);
+	}
+	InsertEmojiAtCursor(cursor, action.emoji);
+
+	auto removed = 0;
+	const auto replaced = [&](int start, int end) {
+		insertPosition = start - removed + 1;
+		if (insertEnd >= end - removed) {
+			insertEnd -= end - start - 1;
+		}
+		removed += end - start - 1;
+	};
+	replaced(action.intervalStart, action.intervalEnd);
+	for (const auto &emoji : more) {
+		replaced(emoji.intervalStart, emoji.intervalEnd);
+	}
+}
+
 } // namespace
 
 const QString InputField::kTagBold = qsl("**");
@@ -1951,6 +2029,20 @@ void InputField::processFormatting(int insertPosition, int insertEnd) {
 							action.emoji = emoji;
 							action.intervalStart = fragmentPosition + (ch - textStart);
 							action.intervalEnd = action.intervalStart + emojiLength;
+							if (!with.isValid()
+								&& fragmentPosition == fragment.position()) {
+								CollectMoreEmoji(
+									action,
+									(_mode == Mode::SingleLine),
+									fragmentPosition,
+									textStart,
+									ch + emojiLength,
+									textEnd,
+									insertEnd,
+									breakTagOnNotLetter,
+									tildeFormatting,
+									isTildeFragment);
+							}
 						}
 						break;
 					}
@@ -2012,13 +2104,12 @@ void InputField::processFormatting(int insertPosition, int insertEnd) {
 				action.intervalStart);
 			cursor.setPosition(action.intervalEnd, QTextCursor::KeepAnchor);
 			if (action.type == ActionType::InsertEmoji) {
-				InsertEmojiAtCursor(cursor, action.emoji);
-				insertPosition = action.intervalStart + 1;
-				if (insertEnd >= action.intervalEnd) {
-					insertEnd -= action.intervalEnd
-						- action.intervalStart
-						- 1;
-				}
+				InsertEmoji(
+					document,
+					action,
+					cursor,
+					insertPosition,
+					insertEnd);
 			} else if (action.type == ActionType::RemoveTag) {
 				RemoveDocumentTags(
 					_st,
@@ -2082,12 +2173,23 @@ void InputField::onDocumentContentsChange(
 	const auto removePosition = position;
 	const auto removeLength = charsRemoved;
 
+	const auto started = getms(true);
 	_correcting = true;
 	QTextCursor(document->docHandle(), 0).joinPreviousEditBlock();
 	const auto guard = gsl::finally([&] {
 		_correcting = false;
 		QTextCursor(document->docHandle(), 0).endEditBlock();
 		handleContentsChanged();
+
+		const auto duration = getms(true) - started;
+		if (duration >= kSlowContentsChange) {
+			DEBUG_LOG(("InputField: change of %1 chars at %2 "
+				"took %3 ms, text length %4."
+				).arg(insertLength
+				).arg(insertPosition
+				).arg(duration
+				).arg(_lastTextWithTags.text.size()));
+		}
 	});
 
 	chopByMaxLength(insertPosition, insertLength);
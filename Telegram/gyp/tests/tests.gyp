@@ -42,6 +42,16 @@
       ],
       'message': 'Running <(RULE_INPUT_ROOT)..',
     }]
+  }, {
+    'target_name': 'tests_aes_ni',
+    'includes': [
+      'common_test.gypi',
+    ],
+    'sources': [
+      '<(src_loc)/mtproto/aes_ni.cpp',
+      '<(src_loc)/mtproto/aes_ni.h',
+      '<(src_loc)/mtproto/aes_ni_tests.cpp',
+    ],
   }, {
     'target_name': 'tests_algorithm',
     'includes': [